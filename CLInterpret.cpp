@@ -22,18 +22,30 @@ Description : A command line interface to the class QuickSort.cpp.
 
 //file output
 #include <cstring>
+#include <fstream>
+
+//cutoff profiles
+#include <algorithm>
+#include <filesystem>
+#include <unistd.h>
 
 /************************************************************/
 // Local includes
 
+#include "included/Introsort.hpp" //the stable fallback
+
 /************************************************************/
 // Using declarations
 
 using uint = unsigned int;
+
+//the builds of the Serial sort with specialized kernels, which take its
+//tuned cutoff so that they are timed on the same leaves
+const char* serialVariants[] {"SerialPointerSort", "SerialShiftSort", "SerialFixedSort", "SerialSpecializedSort"};
 /************************************************************/
 // Function prototypes/global vars/type definitions
 
-const static int flagCount = 7;
+const static int flagCount = 25;
 std::bitset<flagCount> flags;
 
 //aliases for readability/maintainability
@@ -44,6 +56,73 @@ const static int REPS_PER_TRIAL = 3;
 const static int STRIDE = 4;
 const static int SEED = 5;
 const static int WRITE_CSV = 6;
+const static int SCHEME = 7;
+
+/** The partitioning kernels the quicksorts can be run with.
+    NOTE: the order must match schemeNames
+*/
+enum class Scheme { ThreeWay, Block, Simd, DualPivot, ThreePivot, Stable, Adaptive };
+const static int schemeCount = 7;
+const char* schemeNames[] {"3way", "block", "simd", "dual", "3pivot", "stable", "adaptive"};
+const static int PIVOT = 8;
+const static int SAMPLE_SIZE = 9;
+
+/** The pivot selection policies the quicksorts can be run with.
+    NOTE: the order must match pivotNames
+*/
+enum class PivotRule { First, MedianOf3, Ninther, Random, Sample };
+const static int pivotCount = 5;
+const char* pivotNames[] {"first", "median3", "ninther", "random", "sample"};
+const static int SMALL_SORT = 10;
+
+/** The sorts that can be used on ranges below the cutoff.
+    NOTE: the order must match smallSortNames
+*/
+enum class SmallSort { Insertion, Network, Deferred };
+const static int smallSortCount = 3;
+const char* smallSortNames[] {"insertion", "network", "deferred"};
+const static int ELEMENT = 11;
+
+/** The element types the benchmarks can sort.
+    NOTE: the order must match elementNames
+*/
+enum class ElementType { U32, U64, F64, Record, Record32, Record64, Record256, I32, I64, F32, String16 };
+const static int elementCount = 11;
+const char* elementNames[] {"u32", "u64", "f64", "rec16", "rec32", "rec64", "rec256", "i32", "i64", "f32", "str16"};
+const static int DIGIT_BITS = 12;
+const static int THREADS = 13;
+const static int PARALLEL_MIN = 14;
+const static int ENGINE = 15;
+
+/** The ways the serial quicksorts can keep track of the ranges left to sort.
+    NOTE: the order must match engineNames
+*/
+enum class Engine { Recursive, Iterative };
+const static int engineCount = 2;
+const char* engineNames[] {"recursive", "iterative"};
+const static int RUNS = 16;
+const static int MEMORY_BUDGET = 17;
+const static int EXTERNAL_FILE = 18;
+const static int SELECTION = 19;
+
+/** What the quicksorts can be asked to find instead of sorting everything.
+    NOTE: the order must match selectionNames
+*/
+enum class Selection { None, Nth, TopK, Quantiles };
+const static int selectionCount = 4;
+const char* selectionNames[] {"none", "nth", "topk", "quantiles"};
+const static int SELECT_COUNT = 20;
+const static int NORMALIZE = 21;
+const static int STRINGS = 22;
+
+/** The string datasets the string sorts can be run on.
+    NOTE: the order must match stringDataNames
+*/
+enum class StringData { Random, Prefix, Url };
+const static int stringDataCount = 3;
+const char* stringDataNames[] {"random", "prefix", "url"};
+const static int CARDINALITY = 23;
+const static int DISTINCT = 24;
 
 /** Container for all the input the user is asked for. 
     NOTE: Seed is incremented automatically between trials
@@ -58,6 +137,24 @@ struct Input
     uint stride{};
     uint reps{};
     uint seed{};
+    Scheme scheme{Scheme::ThreeWay};
+    PivotRule pivot{PivotRule::First};
+    uint sampleSize{64};
+    SmallSort smallSort{SmallSort::Insertion};
+    ElementType element{ElementType::U32};
+    uint digitBits{8};
+    uint threads{0};
+    uint parallelMin{1'000'000};
+    Engine engine{Engine::Recursive};
+    uint runs{0};
+    uint memoryBudget{256};
+    std::string externalFile{};
+    Selection selection{Selection::None};
+    uint selectCount{100};
+    bool normalize{false};
+    StringData strings{StringData::Random};
+    bool cardinality{false};
+    uint distinct{0};
 };
 
 Input 
@@ -75,6 +172,15 @@ validateInput (Input &in);
 int 
 tryNumericArg(int arg, const std::string &test, const std::string &argName);
 
+int
+tryNamedArg(int arg, const std::string &test, const char* names[], int nameCount, const std::string &argName);
+
+std::string
+profileFilename ();
+
+uint
+loadCutoff (const std::string &sortName, ElementType element, uint fallback);
+
 /************************************************************/
 
 /** Compiles an input object by checking the cli args and prompting
@@ -95,6 +201,11 @@ compileInput (int argc, char* argv[])
         exit(EXIT_SUCCESS);
     }
     Input input = parseArgs(argc, argv);
+    //a cutoff tuned on this machine saves asking for one
+    if(input.cutoff == 0)
+    {
+        input.cutoff = loadCutoff(std::filesystem::path(argv[0]).filename().string(), input.element, 0);
+    }
     validateInput(input);
     return input;
 }
@@ -103,13 +214,51 @@ compileInput (int argc, char* argv[])
 void
 printHelpMenu()
 {
-    std::cout << "Input flags: \n"
+    std::cout << "Modes: \n"
+              << "     tune   - (QuickSorts only) search for the best cutoff of each sort on vs elements\n"
+              << "            of type ty (all types if not given) and save them to this host's profile\n"
+              << "Input flags: \n"
               << "     vs  #  - the vector size to generate\n"
-              << "     ct  #  - the point to switch to insertion sort (cutoff)\n"
+              << "     ct  #  - the point to switch to insertion sort (cutoff). Taken from this host's\n"
+              << "            profile if not given and the sort has been tuned\n"
               << "     nt  #  - the number of trials to run\n"
               << "     rp  #  - the number of times to run each trial\n"
               << "     st  #  - the stride to increase the vector size by between trials\n"
               << "     sd  #  - the seed to be used in the first trial. Incremented between trials\n"
+              << "     pt  s  - the partition scheme to use: 3way (default), block, simd, dual, 3pivot,\n"
+              << "            stable (out of place, keeping equal elements in order, on one thread) or\n"
+              << "            adaptive (block, or 3way on ranges where the pivot repeats)\n"
+              << "     pv  s  - the pivot policy to use: first (default), median3, ninther, random or sample\n"
+              << "     sp  #  - the number of elements the sample pivot policy takes the median of (default 64)\n"
+              << "     ss  s  - the sort to use below the cutoff: insertion (default), network (up to 64 keys)\n"
+              << "            or deferred (one insertion pass over the whole array at the end)\n"
+              << "     ty  s  - the element type to sort: u32 (default), u64, i32, i64, f32, f64, str16 (16\n"
+              << "            random letters), or rec16, rec32, rec64 or rec256 (a record of that many bytes\n"
+              << "            sorted by its 64-bit key)\n"
+              << "     db  #  - the digit width, in bits, of the radix sorts: 8 (default) or 11\n"
+              << "     th  #  - the number of threads the parallel sorts use, 0 (default) for one per\n"
+              << "            hardware thread\n"
+              << "     pp  #  - ranges larger than this are partitioned by every thread at once (default\n"
+              << "            1000000, 0 to never)\n"
+              << "     en  s  - how the serial quicksorts track the ranges left to sort: recursive (default)\n"
+              << "            or iterative (an explicit stack of O(log n) frames)\n"
+              << "     rn  #  - arrange the generated data in this many sorted runs, alternately ascending\n"
+              << "            and descending (default 0, random data)\n"
+              << "     mb  #  - the memory, in MiB, the external sort may use (default 256)\n"
+              << "     xf  s  - the binary file of ty elements for the external sort to sort into s.sorted.\n"
+              << "            If not given, vs elements are generated into a scratch file\n"
+              << "     sl  s  - (TBB, OpenMP and pool sorts only) also time a selection on a copy of the data:\n"
+              << "            none (default), nth (the median), topk (partial sort of the sk smallest)\n"
+              << "            or quantiles (the sk-quantiles, in one pass)\n"
+              << "     sk  #  - the k of topk, or the number of quantiles (default 100)\n"
+              << "     nk  #  - (TBB, OpenMP and pool sorts only) 1 to sort i32, i64, f32 and f64 keys as\n"
+              << "            unsigned integers, normalized before and restored after (default 0)\n"
+              << "     sg  s  - (string sort only) the strings to generate: random (default, random letters of\n"
+              << "            random length), prefix (a few long shared prefixes) or url (URL-like paths)\n"
+              << "     lc  #  - (TBB, OpenMP and pool sorts only) 1 to estimate the number of distinct keys\n"
+              << "            first, and counting sort when there are few (default 0)\n"
+              << "     dk  #  - limit the generated data to about this many distinct elements (default 0, no\n"
+              << "            limit)\n"
               << "Output flags: \n"
               << "     csv n  - write raw data to file n.csv instead of stdout\n";
 }
@@ -127,7 +276,7 @@ printHelpMenu()
 Input
 parseArgs(int argc, char* argv[])
 {
-    const char* args[] {"vs", "ct", "nt", "rp", "st", "sd", "csv"};
+    const char* args[] {"vs", "ct", "nt", "rp", "st", "sd", "csv", "pt", "pv", "sp", "ss", "ty", "db", "th", "pp", "en", "rn", "mb", "xf", "sl", "sk", "nk", "sg", "lc", "dk"};
     Input in;
 
     //skip first arg because it is executable name
@@ -162,6 +311,79 @@ parseArgs(int argc, char* argv[])
             in.filename = argv[++arg];
             flags[WRITE_CSV] = 1;
         }
+        else if(strcmp(args[SCHEME], argv[arg]) == 0)
+        {
+            in.scheme = static_cast<Scheme>(tryNamedArg(SCHEME, argv[++arg], schemeNames, schemeCount, "partition scheme"));
+        }
+        else if(strcmp(args[PIVOT], argv[arg]) == 0)
+        {
+            in.pivot = static_cast<PivotRule>(tryNamedArg(PIVOT, argv[++arg], pivotNames, pivotCount, "pivot policy"));
+        }
+        else if(strcmp(args[SAMPLE_SIZE], argv[arg]) == 0)
+        {
+            in.sampleSize = tryNumericArg(SAMPLE_SIZE, argv[++arg], "sample size");
+        }
+        else if(strcmp(args[SMALL_SORT], argv[arg]) == 0)
+        {
+            in.smallSort = static_cast<SmallSort>(tryNamedArg(SMALL_SORT, argv[++arg], smallSortNames, smallSortCount, "small sort"));
+        }
+        else if(strcmp(args[ELEMENT], argv[arg]) == 0)
+        {
+            in.element = static_cast<ElementType>(tryNamedArg(ELEMENT, argv[++arg], elementNames, elementCount, "element type"));
+        }
+        else if(strcmp(args[DIGIT_BITS], argv[arg]) == 0)
+        {
+            in.digitBits = tryNumericArg(DIGIT_BITS, argv[++arg], "digit width");
+        }
+        else if(strcmp(args[THREADS], argv[arg]) == 0)
+        {
+            in.threads = tryNumericArg(THREADS, argv[++arg], "thread count");
+        }
+        else if(strcmp(args[PARALLEL_MIN], argv[arg]) == 0)
+        {
+            in.parallelMin = tryNumericArg(PARALLEL_MIN, argv[++arg], "parallel partition threshold");
+        }
+        else if(strcmp(args[ENGINE], argv[arg]) == 0)
+        {
+            in.engine = static_cast<Engine>(tryNamedArg(ENGINE, argv[++arg], engineNames, engineCount, "quicksort engine"));
+        }
+        else if(strcmp(args[RUNS], argv[arg]) == 0)
+        {
+            in.runs = tryNumericArg(RUNS, argv[++arg], "run count");
+        }
+        else if(strcmp(args[MEMORY_BUDGET], argv[arg]) == 0)
+        {
+            in.memoryBudget = tryNumericArg(MEMORY_BUDGET, argv[++arg], "memory budget");
+        }
+        else if(strcmp(args[EXTERNAL_FILE], argv[arg]) == 0)
+        {
+            in.externalFile = argv[++arg];
+            flags[EXTERNAL_FILE] = 1;
+        }
+        else if(strcmp(args[SELECTION], argv[arg]) == 0)
+        {
+            in.selection = static_cast<Selection>(tryNamedArg(SELECTION, argv[++arg], selectionNames, selectionCount, "selection"));
+        }
+        else if(strcmp(args[SELECT_COUNT], argv[arg]) == 0)
+        {
+            in.selectCount = tryNumericArg(SELECT_COUNT, argv[++arg], "selection count");
+        }
+        else if(strcmp(args[NORMALIZE], argv[arg]) == 0)
+        {
+            in.normalize = tryNumericArg(NORMALIZE, argv[++arg], "key normalization") != 0;
+        }
+        else if(strcmp(args[STRINGS], argv[arg]) == 0)
+        {
+            in.strings = static_cast<StringData>(tryNamedArg(STRINGS, argv[++arg], stringDataNames, stringDataCount, "string dataset"));
+        }
+        else if(strcmp(args[CARDINALITY], argv[arg]) == 0)
+        {
+            in.cardinality = tryNumericArg(CARDINALITY, argv[++arg], "cardinality pre-pass") != 0;
+        }
+        else if(strcmp(args[DISTINCT], argv[arg]) == 0)
+        {
+            in.distinct = tryNumericArg(DISTINCT, argv[++arg], "distinct element count");
+        }
         //if this case is reached, the flag is invalid
         else {
         {
@@ -206,6 +428,17 @@ validateInput (Input &in)
         std::cout << "vector growth per trial: ";
         std::cin >> in.stride;
     }
+    //every step of a stable quicksort must keep equal elements in order
+    if(in.scheme == Scheme::Stable)
+    {
+        if(in.smallSort == SmallSort::Network)
+        {
+            std::cerr << "The stable scheme needs the insertion or deferred small sort.\n";
+            exit(EXIT_FAILURE);
+        }
+        in.parallelMin = 0;
+        stableFallback = true;
+    }
 }
 
 /** Attempts to convert a single argument to an int.
@@ -231,4 +464,76 @@ tryNumericArg(int arg, const std::string &test, const std::string &argName)
         exit(EXIT_FAILURE);
     }
     return val;
-}
\ No newline at end of file
+}
+
+/** Attempts to match a single argument against a list of names.
+
+    @param arg - the code of the arg being converted
+    @param test - the argument (from argv) to match
+    @param names - the accepted values for the argument
+    @param nameCount - the number of elements in @p names
+    @param argName - the name of the argument. For printing an error if
+        no name matches
+    
+    @return - the index of @p test in @p names
+*/
+int
+tryNamedArg(int arg, const std::string &test, const char* names[], int nameCount, const std::string &argName)
+{
+    for(int i = 0; i < nameCount; ++i)
+    {
+        if(test == names[i])
+        {
+            flags[arg] = 1;
+            return i;
+        }
+    }
+    std::cerr << std::format("'{}' is not a valid {}.\n", test, argName);
+    exit(EXIT_FAILURE);
+}
+
+/** Gets the name of the cutoff profile of this machine. It is kept in the
+    working directory, so the controller and the sorts it runs share it.
+
+    @return - the profile's filename, "<hostname>.cutoffs"
+*/
+std::string
+profileFilename ()
+{
+    char host[256] {};
+    gethostname(host, sizeof(host) - 1);
+    return std::format("{}.cutoffs", host);
+}
+
+/** Looks up the tuned cutoff of a sort in this machine's profile. Each
+    line of the profile is "<sort> <element type> <cutoff>", and the sort
+    "all" holds the cutoff to use for sorts that have not been tuned.
+
+    @param sortName - the name of the sort's executable. The serialVariants
+        look up the cutoff of SerialSort
+    @param element - the element type being sorted
+    @param fallback - the value to return if nothing matches
+
+    @return - the cutoff of @p sortName, else that of "all", else @p fallback
+*/
+uint
+loadCutoff (const std::string &sortName, ElementType element, uint fallback)
+{
+    if(std::ranges::find(serialVariants, sortName) != std::end(serialVariants))
+    {
+        return loadCutoff("SerialSort", element, fallback);
+    }
+
+    std::ifstream profile(profileFilename());
+    std::string sort;
+    std::string type;
+    uint cutoff;
+    uint shared = 0;
+    while (profile >> sort >> type >> cutoff)
+    {
+        if(type != elementNames[static_cast<int>(element)]) { continue; }
+        if(sort == sortName) { return cutoff; }
+        if(sort == "all") { shared = cutoff; }
+    }
+    return shared > 0 ? shared : fallback;
+}
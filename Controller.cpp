@@ -12,6 +12,10 @@ Description : Compiles data on various quicksorts
 #include <iostream>
 #include <unistd.h>
 #include <sys/wait.h>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cmath>
 
 /************************************************************/
 // Local includes
@@ -24,9 +28,41 @@ Description : Compiles data on various quicksorts
 
 /************************************************************/
 // Function prototypes/global vars/type definitions
+
+//every sort in ./Executables, in the order they are run
+const char* sortNames[] {"SerialSort", "SerialPointerSort", "SerialShiftSort", "SerialFixedSort", "SerialSpecializedSort", "PdqSort", "JthreadSort", "TBBSort", "OMPSort", "BoostSort", "PoolSort", "RadixSort", "ParallelRadixSort", "MsdRadixSort", "SampleSort", "PowerSort", "MultiwayMergeSort", "ExternalSort", "ArgSort", "StableSort", "StringSort"};
+
+//the sorts that use the cutoff, and so are tuned. The external sort is
+//left out, as it writes the whole input to disk twice per run, and so is
+//the string sort, as its profile would be keyed on an element type it
+//does not sort. The specialized builds of the Serial sort share its
+//cutoff, so they are timed on the same leaves.
+const char* tunedSorts[] {"SerialSort", "PdqSort", "JthreadSort", "TBBSort", "OMPSort", "BoostSort", "PoolSort", "MsdRadixSort", "SampleSort", "PowerSort", "MultiwayMergeSort", "ArgSort", "StableSort"};
+
+//the CSV row each tuned sort is timed by, in the order of tunedSorts. Some
+//sorts write other rows too, such as std::stable_sort or the time of the
+//argsort's permutation, which the cutoff does not change.
+const char* tunedRows[] {"Serial", "Pdq", "jthread", "TBB", "OpenMP", "boost", "Thread Pool", "MSD Radix", "Samplesort", "Powersort", "Multiway Merge", "Argsort Keys", "Stable Sort"};
+
+//the range of cutoffs tune searches
+const static uint TUNE_MIN_CUTOFF = 4;
+const static uint TUNE_MAX_CUTOFF = 128;
+
 void
 runTrials (Input &in);
 
+void
+runTuning (Input &in);
+
+uint
+tuneCutoff (const std::string &sortName, const std::string &rowName, std::string inputs[], std::string clargs[]);
+
+double
+timeCutoff (const std::string &sortName, const std::string &rowName, uint cutoff, std::string inputs[], std::string clargs[]);
+
+void
+saveCutoffs (ElementType element, const std::map<std::string, uint> &cutoffs);
+
 void
 forkSort (std::string exeName, std::string inputs[], std::string clargs[]);
 /************************************************************/
@@ -34,6 +70,15 @@ forkSort (std::string exeName, std::string inputs[], std::string clargs[]);
 int
 main (int argc, char* argv[])
 {
+    if(argc > 1 && strcmp("tune", argv[1]) == 0)
+    {
+        //the cutoff is what is being searched for, and only one trial is run
+        Input in = parseArgs(argc - 1, argv + 1);
+        in.cutoff = in.trials = in.stride = 1;
+        validateInput(in);
+        runTuning(in);
+        return 0;
+    }
     Input in = compileInput(argc, argv);
     runTrials(in);
 }
@@ -46,9 +91,9 @@ void
 runTrials (Input &in)
 {
     //the command line args
-    std::string clargs[] {"vs", "ct", "nt", "rp", "st", "sd", "csv"};
+    std::string clargs[] {"vs", "ct", "nt", "rp", "st", "sd", "csv", "pt", "pv", "sp", "ss", "ty", "db", "th", "pp", "en", "rn", "mb", "xf", "sl", "sk", "nk", "sg", "lc", "dk"};
     //the input data as strings
-    std::string inputs[] = {std::to_string(in.vecSize).c_str(), std::to_string(in.cutoff).c_str(), std::to_string(in.trials).c_str(), std::to_string(in.reps).c_str(), std::to_string(in.stride).c_str(), std::to_string(in.seed).c_str(), in.filename.data()};
+    std::string inputs[] = {std::to_string(in.vecSize).c_str(), std::to_string(in.cutoff).c_str(), std::to_string(in.trials).c_str(), std::to_string(in.reps).c_str(), std::to_string(in.stride).c_str(), std::to_string(in.seed).c_str(), in.filename.data(), schemeNames[static_cast<int>(in.scheme)], pivotNames[static_cast<int>(in.pivot)], std::to_string(in.sampleSize), smallSortNames[static_cast<int>(in.smallSort)], elementNames[static_cast<int>(in.element)], std::to_string(in.digitBits), std::to_string(in.threads), std::to_string(in.parallelMin), engineNames[static_cast<int>(in.engine)], std::to_string(in.runs), std::to_string(in.memoryBudget), in.externalFile, selectionNames[static_cast<int>(in.selection)], std::to_string(in.selectCount), std::to_string(in.normalize), stringDataNames[static_cast<int>(in.strings)], std::to_string(in.cardinality), std::to_string(in.distinct)};
 
     for(uint i = 0; i < in.trials; ++i)
     {
@@ -57,18 +102,176 @@ runTrials (Input &in)
         inputs[5] = std::to_string(in.seed).c_str();
         inputs[0] = std::to_string(in.vecSize).c_str();
 
-        forkSort("SerialSort", inputs, clargs);
-        forkSort("JthreadSort", inputs, clargs);
-        forkSort("TBBSort", inputs, clargs);
-        forkSort("OMPSort", inputs, clargs);
-        forkSort("BoostSort", inputs, clargs);
-        forkSort("PoolSort", inputs, clargs);
+        for(const char* sort : sortNames)
+        {
+            //unless a cutoff was given, each sort uses its own tuned one
+            if(!flags[CUTOFF])
+            {
+                inputs[1] = std::to_string(loadCutoff(sort, in.element, in.cutoff));
+            }
+            forkSort(sort, inputs, clargs);
+        }
 
         in.vecSize += in.stride;
         std::cout << std::format ("Trial {} finished\n", i);
     }
 }
 
+/** Finds the best cutoff of every tuned sort on this machine, for the
+    element type given (or all of them), and saves them to its profile.
+
+    @param in - the input to tune with. The vector size, reps, seed and
+        every option but the cutoff, the selection and the cardinality
+        estimate are passed to the sorts as given.
+*/
+void
+runTuning (Input &in)
+{
+    for(int type = 0; type < elementCount; ++type)
+    {
+        if(flags[ELEMENT] && type != static_cast<int>(in.element)) { continue; }
+
+        std::string clargs[] {"vs", "ct", "nt", "rp", "st", "sd", "csv", "pt", "pv", "sp", "ss", "ty", "db", "th", "pp", "en", "rn", "mb", "xf", "sl", "sk", "nk", "sg", "lc", "dk"};
+        //no selection or cardinality estimate, as only the sort rows are
+        //timed
+        std::string inputs[] = {std::to_string(in.vecSize), std::to_string(in.cutoff), std::to_string(in.trials), std::to_string(in.reps), std::to_string(in.stride), std::to_string(in.seed), std::format("tune-{}.csv", getpid()), schemeNames[static_cast<int>(in.scheme)], pivotNames[static_cast<int>(in.pivot)], std::to_string(in.sampleSize), smallSortNames[static_cast<int>(in.smallSort)], elementNames[type], std::to_string(in.digitBits), std::to_string(in.threads), std::to_string(in.parallelMin), engineNames[static_cast<int>(in.engine)], std::to_string(in.runs), std::to_string(in.memoryBudget), in.externalFile, "none", std::to_string(in.selectCount), std::to_string(in.normalize), stringDataNames[static_cast<int>(in.strings)], "0", std::to_string(in.distinct)};
+
+        std::map<std::string, uint> cutoffs;
+        for(std::size_t i = 0; i < std::size(tunedSorts); ++i)
+        {
+            const char* sort = tunedSorts[i];
+            if(!std::filesystem::exists(std::format("./Executables/{}", sort)))
+            {
+                std::cout << std::format ("{} has not been built, skipping it.\n", sort);
+                continue;
+            }
+            cutoffs[sort] = tuneCutoff(sort, tunedRows[i], inputs, clargs);
+            std::cout << std::format ("{} ({}): cutoff {}\n", sort, elementNames[type], cutoffs[sort]);
+        }
+        if(!cutoffs.empty()) { saveCutoffs(static_cast<ElementType>(type), cutoffs); }
+    }
+    std::cout << std::format ("Saved to {}\n", profileFilename());
+}
+
+/** Finds the cutoff at which a sort runs fastest with a golden-section
+    search over [TUNE_MIN_CUTOFF, TUNE_MAX_CUTOFF]. This assumes the time is
+    unimodal in the cutoff, which holds well enough for a small sort, and
+    takes about a dozen runs instead of one per cutoff.
+
+    @param sortName - the name of the executable to tune
+    @param rowName - the name of the CSV rows holding its sort times
+    @param inputs - the values of the command line args, as for forkSort
+    @param clargs - the command line args
+
+    @return - the fastest cutoff found
+*/
+uint
+tuneCutoff (const std::string &sortName, const std::string &rowName, std::string inputs[], std::string clargs[])
+{
+    const double invPhi = (std::sqrt(5.0) - 1) / 2;
+
+    //the search revisits one of its two points each step, so keep them
+    std::map<uint, double> times;
+    auto timeAt = [&] (uint cutoff) {
+        if(!times.contains(cutoff)) { times[cutoff] = timeCutoff(sortName, rowName, cutoff, inputs, clargs); }
+        return times[cutoff];
+    };
+
+    uint lo = TUNE_MIN_CUTOFF;
+    uint hi = TUNE_MAX_CUTOFF;
+    while (hi - lo > 3)
+    {
+        uint step = std::lround((hi - lo) * invPhi);
+        uint left = hi - step;
+        uint right = lo + step;
+        if(timeAt(left) < timeAt(right)) { hi = right; }
+        else { lo = left; }
+    }
+
+    //too few cutoffs are left to split, so try them all
+    uint best = lo;
+    for(uint cutoff = lo + 1; cutoff <= hi; ++cutoff)
+    {
+        if(timeAt(cutoff) < timeAt(best)) { best = cutoff; }
+    }
+    return best;
+}
+
+/** Runs a sort with the given cutoff and reads its times back.
+
+    @param sortName - the name of the executable to run
+    @param rowName - the name of the CSV rows to read the times from. Rows
+        of keys sorted normalized, named "<rowName> Normalized", count too
+    @param cutoff - the cutoff to run it with
+    @param inputs - the values of the command line args. The csv file
+        (inputs[6]) is overwritten.
+    @param clargs - the command line args
+
+    @return - the median time of the reps, in ms
+*/
+double
+timeCutoff (const std::string &sortName, const std::string &rowName, uint cutoff, std::string inputs[], std::string clargs[])
+{
+    std::filesystem::remove(inputs[6]);
+    inputs[1] = std::to_string(cutoff);
+    forkSort(sortName, inputs, clargs);
+
+    //the time is the second column of each rep's line
+    std::vector<double> times;
+    std::ifstream file(inputs[6]);
+    for(std::string line; std::getline(file, line);)
+    {
+        std::string name = line.substr(0, line.find(','));
+        if(name != rowName && name != rowName + " Normalized") { continue; }
+        std::size_t start = line.find(',') + 1;
+        times.push_back(std::stod(line.substr(start, line.find(',', start) - start)));
+    }
+    file.close();
+    std::filesystem::remove(inputs[6]);
+
+    //the median ignores the odd rep that is slowed down by something else
+    if(times.empty()) { return HUGE_VAL; }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+/** Writes tuned cutoffs to this machine's profile, replacing the ones
+    already there for the same sorts and element type. The median of the
+    cutoffs is also saved as "all", for sorts that were not tuned.
+
+    @param element - the element type the cutoffs were tuned on
+    @param cutoffs - the cutoff of each sort
+*/
+void
+saveCutoffs (ElementType element, const std::map<std::string, uint> &cutoffs)
+{
+    std::vector<uint> values;
+    for(const auto &[sort, cutoff] : cutoffs) { values.push_back(cutoff); }
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    std::map<std::string, uint> tuned = cutoffs;
+    tuned["all"] = values[values.size() / 2];
+
+    //keep every line of the old profile that is not being replaced
+    std::vector<std::string> kept;
+    std::ifstream oldProfile(profileFilename());
+    std::string sort;
+    std::string type;
+    uint cutoff;
+    while (oldProfile >> sort >> type >> cutoff)
+    {
+        if(type == elementNames[static_cast<int>(element)] && tuned.contains(sort)) { continue; }
+        kept.push_back(std::format("{} {} {}", sort, type, cutoff));
+    }
+    oldProfile.close();
+
+    std::ofstream profile(profileFilename(), std::ios::trunc);
+    for(const std::string &line : kept) { profile << line << '\n'; }
+    for(const auto &[name, value] : tuned)
+    {
+        profile << std::format("{} {} {}\n", name, elementNames[static_cast<int>(element)], value);
+    }
+}
+
 /** forks then calls execvp on exeName
 
     @param in - some of the input being passed to the process being exec'd
@@ -79,12 +282,19 @@ void
 forkSort (std::string exeName, std::string inputs[], std::string clargs[])
 {
     std::string exeRelativeFP = std::format ("./Executables/{}", exeName);
-    char* args[] {exeRelativeFP.data(), clargs[0].data(), inputs[0].data(), clargs[1].data(), inputs[1].data(), clargs[2].data(), inputs[2].data(), clargs[3].data(), inputs[3].data(), clargs[4].data(), inputs[4].data(), clargs[5].data(), inputs[5].data(), clargs[6].data(), inputs[6].data(), nullptr};
+    //flag/value pairs, in the same order as clargs
+    std::vector<char*> args {exeRelativeFP.data()};
+    for(int i = 0; i < flagCount; ++i)
+    {
+        args.push_back(clargs[i].data());
+        args.push_back(inputs[i].data());
+    }
+    args.push_back(nullptr);
     
     pid_t id = fork();
     if(id == 0)
     {
-        execvp(exeRelativeFP.c_str(), args);
+        execvp(exeRelativeFP.c_str(), args.data());
         exit(0);
     }
     int status;
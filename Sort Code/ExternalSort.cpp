@@ -0,0 +1,620 @@
+/*
+Filename    : ExternalSort.cpp
+Author      : Peter Freedman
+Course      : CSCI 476
+Assignment  : CSCI 476 - Final Project
+Description : Generates the ExternalSort executable, which sorts a binary
+    file that may be larger than memory. Chunks that fit the memory budget
+    are sorted with the thread pool quicksort and written out as runs,
+    which are then merged with a loser tree. The time spent on I/O and on
+    sorting is reported separately.
+*/
+
+/************************************************************/
+// System includes
+#include <iostream>
+#include <concepts>
+
+#include <random> 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <filesystem>
+
+
+/************************************************************/
+// Local includes
+#include "../CLInterpret.cpp"
+#include "../included/Timer.hpp"
+#include "../included/BlockPartition.hpp"
+#include "../included/SimdPartition.hpp"
+#include "../included/StableSort.hpp"
+#include "../included/Cardinality.hpp"
+#include "../included/PivotPolicies.hpp"
+#include "../included/Introsort.hpp"
+#include "../included/MultiPivot.hpp"
+#include "../included/SmallSort.hpp"
+#include "../included/FinishingPass.hpp"
+#include "../included/IterativeQuickSort.hpp"
+#include "../included/ParallelPartition.hpp"
+#include "../included/Ordering.hpp"
+#include "../included/BS_thread_pool.hpp"
+#include "../included/ExternalSort.hpp"
+
+
+
+/************************************************************/
+// Using declarations
+
+template<typename Callable>
+concept callable = std::invocable<Callable>;
+
+template <typename Iter>
+concept random_access = std::random_access_iterator<Iter>;
+
+/************************************************************/
+// Function prototypes/global vars/type definitions
+
+template <random_access Iter, typename Pivot, typename Compare>
+void
+quickSort (Iter begin, Iter end, uint cutoff, BS::thread_pool &threads, uint parallelMin, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Engine engine, Compare less);
+
+template<typename Function>
+void
+forEachStarted (BS::thread_pool &threads, std::size_t count, const Function &f);
+
+template<callable Function>
+double 
+timeAlgorithm (const Function &f);
+
+template<typename Function>
+void
+withPivot (const Input &in, const Function &f);
+
+template<typename T>
+std::vector<T>
+generateTestData(const unsigned size, const unsigned seed);
+
+void
+runReps (Input &in);
+
+template<typename T, typename Comp, typename Proj>
+void
+runReps (Input &in, Comp comp, Proj proj);
+
+template <random_access Iter, typename Compare>
+void
+insertionSort (Iter first, Iter last, Compare less);
+
+template <random_access Iter, typename Compare>
+void
+smallSort (Iter first, Iter last, SmallSort leaf, Compare less);
+
+template<random_access Iter, typename Value, typename Compare>
+std::pair<Iter, Iter>
+partition (Iter begin, Iter end, const Value &pivot, Compare less);
+
+template<random_access Iter, typename Value, typename Compare>
+std::pair<Iter, Iter>
+partition (Iter begin, Iter end, const Value &pivot, Scheme scheme, Compare less);
+
+template<random_access Iter, typename Compare>
+Segments<Iter>
+partition (Iter begin, Iter end, Scheme scheme, Compare less);
+
+template <random_access Iter, typename Pivot, typename Compare>
+void
+quickSort (Iter begin, Iter end, uint cutoff, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Compare less);
+
+template <random_access Iter, typename Pivot, typename Compare>
+void
+iterativeQuickSort (Iter begin, Iter end, uint cutoff, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Compare less);
+
+template <random_access Iter, typename Pivot, typename Compare>
+void
+serialQuickSort (Iter begin, Iter end, uint cutoff, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Engine engine, Compare less);
+/************************************************************/
+
+int
+main (int argc, char* argv[])
+{
+    Input in = compileInput(argc, argv);
+    runReps(in);
+}
+
+/** This sort is the one that was replaced when exes were being generated.
+    Due to the changing nature of this method, if documentation is needed 
+    it can be found in the file "QuickSort.cpp".
+*/
+template <random_access Iter, typename Pivot, typename Compare>
+void
+quickSort (Iter begin, Iter end, uint cutoff, BS::thread_pool &threads, uint parallelMin, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Engine engine, Compare less)
+{
+    if(std::distance(begin, end) <= cutoff)
+    {
+        smallSort(begin, end, leaf, less);
+        return;
+    }
+    if(budget == 0)
+    {
+        heapsortFallback(begin, end, less);
+        return;
+    }
+
+    if(scheme == Scheme::DualPivot || scheme == Scheme::ThreePivot)
+    {
+        auto parts = partition(begin, end, scheme, less);
+        for(int i = 0; i < parts.count; ++i)
+        {
+            auto [first, last] = parts.ranges[i];
+            if(i + 1 < parts.count)
+            {
+                threads.push_task([=, &threads] {quickSort(first, last, cutoff, threads, parallelMin, scheme, pick, budget - 1, leaf, engine, less);});
+            }
+            else {
+                serialQuickSort(first, last, cutoff, scheme, pick, budget - 1, leaf, engine, less);
+            }
+        }
+        return;
+    }
+
+    auto pivot = pick(begin, end, less);
+    //a range this big would keep the other threads waiting on one core
+    auto [lowPivot, hiPivot] = parallelMin > 0 && std::distance(begin, end) > parallelMin
+        ? parallelPartition(begin, end, pivot, less, threads.get_thread_count(), [&threads] (std::size_t count, const auto &f) {
+            forEachStarted(threads, count, f);
+        })
+        : partition(begin, end, pivot, scheme, less);
+
+    threads.push_task([=, &threads] {quickSort(begin, lowPivot, cutoff, threads, parallelMin, scheme, pick, budget - 1, leaf, engine, less);});
+    serialQuickSort(hiPivot, end, cutoff, scheme, pick, budget - 1, leaf, engine, less);
+}
+
+/** Calls f(0) on the calling thread and pushes f(1) to f(count - 1) to the
+    pool. Once f(0) returns, the tasks that have not started yet are skipped
+    instead of waited for: this may itself be running on a worker, and if
+    every worker waited here, nothing would be left to run them.
+
+    @param threads - the pool to run on
+    @param count - the number of calls
+    @param f - the function to call, which must cope with skipped calls
+*/
+template<typename Function>
+void
+forEachStarted (BS::thread_pool &threads, std::size_t count, const Function &f)
+{
+    //0 while queued, 1 while running, 2 once finished and 3 if skipped
+    std::vector<std::shared_ptr<std::atomic<int>>> states;
+    for(std::size_t i = 1; i < count; ++i)
+    {
+        auto state = std::make_shared<std::atomic<int>>(0);
+        states.push_back(state);
+        threads.push_task([state, &f, i] {
+            int queued = 0;
+            if(!state->compare_exchange_strong(queued, 1)) { return; }
+            f(i);
+            state->store(2);
+            state->notify_one();
+        });
+    }
+    f(0);
+
+    for(auto &state : states)
+    {
+        int queued = 0;
+        if(state->compare_exchange_strong(queued, 3)) { continue; }
+        state->wait(1);
+    }
+}
+
+/** Times the algorithm passed in as a parameter
+
+    @param f - the function to time
+    @return - the time the function took to execute, as a double
+*/
+template<callable Function>
+double 
+timeAlgorithm (const Function &f)
+{
+    Timer t;
+    f();
+    t.stop();
+    return t.getElapsedMs();
+}
+
+/** Calls f with the pivot policy selected by the user.
+
+    @param in - the user input holding the pivot policy and sample size
+    @param f - the function to call with the policy object
+*/
+template<typename Function>
+void
+withPivot (const Input &in, const Function &f)
+{
+    switch(in.pivot)
+    {
+        case PivotRule::MedianOf3: f(MedianOf3Pivot{}); break;
+        case PivotRule::Ninther: f(NintherPivot{}); break;
+        case PivotRule::Random: f(RandomPivot{}); break;
+        case PivotRule::Sample: f(SampleMedianPivot{in.sampleSize}); break;
+        default: f(FirstPivot{}); break;
+    }
+}
+
+/** Generates a vector of random elements of type T. uints are drawn from
+    the original 32-bit generator, everything else from randomElement.
+
+    @param size - the size of the vector to be generated
+    
+    @return - a vector of size @p size full of elements in the range [0, 100'000'000)
+
+    NOTE: The random numbers generated by this method will be in the same order between
+    executions.
+*/
+template<typename T>
+std::vector<T>
+generateTestData(const unsigned size, const unsigned seed)
+{
+    std::vector<T> ret(size);
+    if constexpr (std::is_same_v<T, uint>)
+    {
+        static std::mt19937 gen{seed};
+        std::ranges::generate(ret, [&] { return gen();});
+    }
+    else {
+        static std::mt19937_64 gen{seed};
+        std::ranges::generate(ret, [&] { return randomElement<T>(gen);});
+    }
+    return ret;
+}
+
+/** Runs trials on the element type selected by the user. Records are
+    ordered by their key.
+
+    @param in - the user input to be used for all trials.
+*/
+void
+runReps (Input &in)
+{
+    switch(in.element)
+    {
+        case ElementType::U64: runReps<std::uint64_t>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::F64: runReps<double>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::I32: runReps<std::int32_t>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::I64: runReps<std::int64_t>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::F32: runReps<float>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::String16: runReps<String16>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::Record: runReps<Record>(in, std::ranges::less{}, &Record::key); break;
+        case ElementType::Record32: runReps<Record32>(in, std::ranges::less{}, &Record32::key); break;
+        case ElementType::Record64: runReps<Record64>(in, std::ranges::less{}, &Record64::key); break;
+        case ElementType::Record256: runReps<Record256>(in, std::ranges::less{}, &Record256::key); break;
+        default: runReps<uint>(in, std::ranges::less{}, std::identity{}); break;
+    }
+}
+
+/** Runs trials according to user specified traits
+
+    @param in - the user input to be used for all trials.
+    
+    NOTE: This method will generate the following: 
+    1) in.trials * in.reps vectors of size in.vecSize
+    2) # of sorts being run copies of the vectors in 1)
+    3) in.trials * in.reps * # of sorts {sort, time} pairs
+    over the duration of its runtime. 
+
+    NOTE: for the sake of readability, if no CSV is generated, only 
+    the data from the first 5 reps will be printed.
+
+    NOTE: three rows are written per rep: the whole sort, then the time
+    spent reading and writing, then the time spent sorting and merging.
+    The extra bytes column is the memory used for the chunks, and the last
+    column the number of sorted runs written. The rn flag is ignored, as
+    the generated data need not fit in memory to be arranged.
+
+    @param comp - the comparator to sort with
+    @param proj - the projection applied to each element before comparing
+*/
+template<typename T, typename Comp, typename Proj>
+void
+runReps (Input &in, Comp comp, Proj proj)
+{
+    std::ofstream file(in.filename, std::ios::app);
+    ProjectedLess<Comp, Proj> less{comp, proj};
+    std::size_t budget = std::size_t{in.memoryBudget} << 20;
+
+    for(uint i = 0; i < in.reps; ++i)
+    {
+        //without a file to sort, generate one a budget's worth at a time
+        std::string inputPath = in.externalFile;
+        std::size_t size = in.vecSize;
+        if(inputPath.empty())
+        {
+            inputPath = std::format("external-{}.bin", getpid());
+            std::ofstream scratch(inputPath, std::ios::binary | std::ios::trunc);
+            for(std::size_t done = 0; done < size; )
+            {
+                std::size_t count = std::min(size - done, std::max<std::size_t>(1, budget / sizeof(T)));
+                std::vector<T> data = generateTestData<T> (count, in.seed);
+                scratch.write(reinterpret_cast<const char*>(data.data()), count * sizeof(T));
+                done += count;
+            }
+        }
+        else {
+            size = std::filesystem::file_size(inputPath) / sizeof(T);
+        }
+        std::string outputPath = inputPath + ".sorted";
+
+        heapsortFallbacks = 0;
+        maxStackDepth = 0;
+        ExternalTimes times;
+        double time = 0;
+        withPivot(in, [&] (auto pick) {
+            time = timeAlgorithm([&] {
+                BS::thread_pool threads(in.threads);
+                times = externalSort<T>(inputPath, outputPath, budget, less, [&] (auto first, auto last) {
+                    quickSort(first, last, in.cutoff, threads, in.parallelMin, in.scheme, pick, depthBudget(std::distance(first, last)), in.smallSort, in.engine, less);
+                    threads.wait_for_tasks();
+                    if(in.smallSort == SmallSort::Deferred)
+                    {
+                        finishingPass(first, last, in.cutoff, less, threads.get_thread_count(), [&threads] (std::size_t count, const auto &f) {
+                            for(std::size_t i = 0; i < count; ++i) { threads.push_task([&f, i] {f(i);}); }
+                            threads.wait_for_tasks();
+                        });
+                    }
+                });
+            });
+        });
+
+        if(in.externalFile.empty())
+        {
+            std::filesystem::remove(inputPath);
+            std::filesystem::remove(outputPath);
+        }
+
+        //one row for the whole sort, then one each for its I/O and CPU time
+        std::size_t extraBytes = std::min(budget, size * sizeof(T));
+        std::pair<const char*, double> rows[] {{"External", time}, {"External I/O", times.ioMs}, {"External CPU", times.cpuMs}};
+        for(const auto &[name, ms] : rows)
+        {
+            std::string output = std::format("{},{},{},{},{},{},{},{},{},{},{}\n", name, ms, size, schemeNames[static_cast<int>(in.scheme)], pivotNames[static_cast<int>(in.pivot)], heapsortFallbacks.load(), smallSortNames[static_cast<int>(in.smallSort)], elementNames[static_cast<int>(in.element)], extraBytes, maxStackDepth.load(), times.runs);
+            file.write(output.c_str(), output.length());
+        }
+    }
+}
+
+/** Tests all sorts numTrials times using the following methods:
+    1) takes the input vector size and adds a random value between 0 and 10000 to it
+    2) takes the input cutoff and adds 1 to it on consecutive runs numTrials times
+    
+    @param numTrials - the number of times to repeat the above process
+    @param in - the user input to use as the basis for these trials
+*/
+template <random_access Iter, typename Compare>
+void
+insertionSort (Iter first, Iter last, Compare less)
+{
+    if(std::distance(first, last) < 2) { return; }
+
+    Iter prev;
+    for(Iter cur = std::next(first); cur != last; ++cur)
+    {
+        //move the current value out
+        auto key = std::move(*cur);
+        prev = std::prev(cur);
+        while (std::distance (first, prev) >= 0 && less(key, *prev))
+        {
+            //move the value of prev up one
+            *(std::next(prev)) = std::move(*prev);
+            //decrement prev
+           --prev;
+        }
+        *(std::next(prev)) = std::move(key);
+    }
+}
+
+/** Sorts a range below the cutoff with the sort selected by leaf. Ranges
+    the sorting network cannot handle use insertion sort, and deferred
+    ranges are left as they are.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param leaf - the small sort to use
+    @param less - the ordering to sort by
+*/
+template <random_access Iter, typename Compare>
+void
+smallSort (Iter first, Iter last, SmallSort leaf, Compare less)
+{
+    //deferred ranges are sorted by finishingPass once the quicksort is done
+    if(leaf == SmallSort::Deferred) { return; }
+    if(leaf == SmallSort::Network && networkSort(first, last, less)) { return; }
+    insertionSort(first, last, less);
+}
+
+/** Partitions the range [begin, end) such that all elements less than *pivot 
+    come before pivot, all elements equal to *pivot are in the middle, and all
+    elements greater than *pivot are after towards the end.
+    
+    NOTE: Unstable partition
+    
+    @param begin - the start of the range to partition
+    @param end - one past the end of the range to partition
+    @param pivot - an iterator pointing to the value on which the range should 
+        be partitioned
+    @param less - the ordering to partition by
+    
+    @return - a pair such that all elements to the left of pair.first
+            are less than pivot, all elements between pair.first and 
+            pair.second are equal to pivot, and all elements after
+            pair.second are greater than the pivot.
+*/
+template<random_access Iter, typename Value, typename Compare>
+std::pair<Iter, Iter>
+partition (Iter begin, Iter end, const Value &pivot, Compare less)
+{
+    if(std::distance(begin, end) <= 1) { return {begin, end}; }
+  
+    Iter cur = begin;
+    Iter nextLow = begin;
+    Iter nextHigh = end;
+
+    while (cur < nextHigh)
+    {
+        if(less(*cur, pivot))
+        {
+            std::iter_swap(cur, nextLow);
+            ++nextLow;
+            ++cur;
+        }
+        else if(less(pivot, *cur))
+        {
+            --nextHigh;
+            std::iter_swap(cur, nextHigh);
+        } 
+        else { ++cur; }
+    }
+
+    return {nextLow, nextHigh};
+}
+
+/** Partitions the range [begin, end) around pivot using the kernel selected
+    by scheme. See partition, blockPartition, simdPartition and
+    stablePartition for the exact contracts. The adaptive scheme uses
+    blockPartition unless pivotRepeats finds copies of the pivot.
+
+    @param begin - the start of the range to partition
+    @param end - one past the end of the range to partition
+    @param pivot - the value on which the range should be partitioned
+    @param scheme - the partitioning kernel to use
+    @param less - the ordering to partition by
+
+    @return - a pair such that all elements to the left of pair.first
+            are less than pivot, all elements between pair.first and
+            pair.second are equal to pivot, and all elements after
+            pair.second are not less than the pivot.
+*/
+template<random_access Iter, typename Value, typename Compare>
+std::pair<Iter, Iter>
+partition (Iter begin, Iter end, const Value &pivot, Scheme scheme, Compare less)
+{
+    if(scheme == Scheme::Block) { return blockPartition(begin, end, pivot, less); }
+    if(scheme == Scheme::Simd) { return simdPartition(begin, end, pivot, less); }
+    if(scheme == Scheme::Stable) { return stablePartition(begin, end, pivot, less); }
+    if(scheme == Scheme::Adaptive && !pivotRepeats(begin, end, pivot, less)) { return blockPartition(begin, end, pivot, less); }
+    return partition(begin, end, pivot, less);
+}
+
+/** Partitions the range [begin, end) with the multi-pivot kernel selected
+    by scheme. See dualPivotPartition and threePivotPartition.
+
+    @param begin - the start of the range to partition
+    @param end - one past the end of the range to partition
+    @param scheme - the partitioning kernel to use, DualPivot or ThreePivot
+    @param less - the ordering to partition by
+
+    @return - the ranges that are left to sort
+*/
+template<random_access Iter, typename Compare>
+Segments<Iter>
+partition (Iter begin, Iter end, Scheme scheme, Compare less)
+{
+    if(scheme == Scheme::ThreePivot) { return threePivotPartition(begin, end, less); }
+    return dualPivotPartition(begin, end, less);
+}
+
+/** Performs a 3-way (or, if scheme asks for it, multi-pivot) serial
+    quicksort on the range [begin, end), switching to insertion sort on
+    smaller sample sizes.
+
+    @param begin - the start of the range to be sorted
+    @param end - the end (exclusive) of the range to be sorted
+    @param cutoff - the point at which insertion sort should be used instead
+    @param scheme - the partitioning kernel to use
+    @param pick - the pivot policy, called on each range to choose its pivot
+    @param budget - the number of partitioning levels left before the range
+        is heapsorted instead
+    @param leaf - the sort to use on ranges below the cutoff
+    @param less - the ordering to sort by
+    @param useOMP - if this is 1, OMP tasks will be used to parallelize the sort
+        the default value of this parameter is 0.
+*/
+template <random_access Iter, typename Pivot, typename Compare>
+void
+quickSort (Iter begin, Iter end, uint cutoff, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Compare less)
+{
+    if(std::distance(begin, end) <= cutoff)
+    {
+        smallSort(begin, end, leaf, less);
+        return;
+    }
+    if(budget == 0)
+    {
+        heapsortFallback(begin, end, less);
+        return;
+    }
+    if(scheme == Scheme::DualPivot || scheme == Scheme::ThreePivot)
+    {
+        for(const auto &part : partition(begin, end, scheme, less))
+        {
+            quickSort(part.first, part.second, cutoff, scheme, pick, budget - 1, leaf, less);
+        }
+        return;
+    }
+
+    auto pivot = pick(begin, end, less);
+    auto [lowPivot, hiPivot] = partition(begin, end, pivot, scheme, less);
+
+    quickSort(begin, lowPivot, cutoff, scheme, pick, budget - 1, leaf, less);
+    quickSort(hiPivot, end, cutoff, scheme, pick, budget - 1, leaf, less);
+}
+
+/** Performs the same sort as quickSort, but keeps the ranges left to sort
+    on the explicit stack of quickSortLoop instead of recursing.
+
+    @param begin - the start of the range to be sorted
+    @param end - the end (exclusive) of the range to be sorted
+    @param cutoff - the point at which the small sort should be used instead
+    @param scheme - the partitioning kernel to use
+    @param pick - the pivot policy, called on each range to choose its pivot
+    @param budget - the number of partitioning levels left before the range
+        is heapsorted instead
+    @param leaf - the sort to use on ranges below the cutoff
+    @param less - the ordering to sort by
+*/
+template <random_access Iter, typename Pivot, typename Compare>
+void
+iterativeQuickSort (Iter begin, Iter end, uint cutoff, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Compare less)
+{
+    quickSortLoop(begin, end, cutoff, budget, less,
+        [=] (Iter first, Iter last) { smallSort(first, last, leaf, less); },
+        [=] (Iter first, Iter last) {
+            if(scheme == Scheme::DualPivot || scheme == Scheme::ThreePivot)
+            {
+                return partition(first, last, scheme, less);
+            }
+            auto pivot = pick(first, last, less);
+            auto [lowPivot, hiPivot] = partition(first, last, pivot, scheme, less);
+            Segments<Iter> parts;
+            parts.add(first, lowPivot);
+            parts.add(hiPivot, last);
+            return parts;
+        });
+}
+
+/** Sorts [begin, end) on the calling thread with the engine selected by the
+    user. The parallel sort hands its leaf ranges to this.
+
+    @param engine - recursive for quickSort, iterative for iterativeQuickSort
+*/
+template <random_access Iter, typename Pivot, typename Compare>
+void
+serialQuickSort (Iter begin, Iter end, uint cutoff, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Engine engine, Compare less)
+{
+    if(engine == Engine::Iterative)
+    {
+        iterativeQuickSort(begin, end, cutoff, scheme, pick, budget, leaf, less);
+    }
+    else {
+        quickSort(begin, end, cutoff, scheme, pick, budget, leaf, less);
+    }
+}
@@ -0,0 +1,175 @@
+/*
+Filename    : MsdRadix.cpp
+Author      : Peter Freedman
+Course      : CSCI 476
+Assignment  : CSCI 476 - Final Project
+Description : Generates the MsdRadixSort executable, a parallel in-place
+    MSD radix sort of the unsigned integer keys on the BS::thread_pool.
+    Unlike the LSD sorts it needs no second copy of the array.
+*/
+
+/************************************************************/
+// System includes
+#include <iostream>
+#include <concepts>
+
+#include <random>
+#include <algorithm>
+
+/************************************************************/
+// Local includes
+#include "../CLInterpret.cpp"
+#include "../included/Timer.hpp"
+#include "../included/Ordering.hpp"
+#include "../included/KeyNormalization.hpp"
+#include "../included/InPlaceRadix.hpp"
+#include "../included/BS_thread_pool.hpp"
+
+
+
+/************************************************************/
+// Using declarations
+
+template<typename Callable>
+concept callable = std::invocable<Callable>;
+
+/************************************************************/
+// Function prototypes/global vars/type definitions
+
+template<callable Function>
+double
+timeAlgorithm (const Function &f);
+
+template<typename T>
+std::vector<T>
+generateTestData(const unsigned size, const unsigned seed);
+
+void
+runReps (Input &in);
+
+template<typename T, typename KeyOf>
+void
+runReps (Input &in, KeyOf keyOf);
+/************************************************************/
+
+int
+main (int argc, char* argv[])
+{
+    Input in = compileInput(argc, argv);
+    runReps(in);
+}
+
+/** Times the algorithm passed in as a parameter
+
+    @param f - the function to time
+    @return - the time the function took to execute, as a double
+*/
+template<callable Function>
+double
+timeAlgorithm (const Function &f)
+{
+    Timer t;
+    f();
+    t.stop();
+    return t.getElapsedMs();
+}
+
+/** Generates a vector of random elements of type T. uints are drawn from
+    the original 32-bit generator, everything else from randomElement.
+
+    @param size - the size of the vector to be generated
+
+    @return - a vector of size @p size full of elements in the range [0, 100'000'000)
+
+    NOTE: The random numbers generated by this method will be in the same order between
+    executions.
+*/
+template<typename T>
+std::vector<T>
+generateTestData(const unsigned size, const unsigned seed)
+{
+    std::vector<T> ret(size);
+    if constexpr (std::is_same_v<T, uint>)
+    {
+        static std::mt19937 gen{seed};
+        std::ranges::generate(ret, [&] { return gen();});
+    }
+    else {
+        static std::mt19937_64 gen{seed};
+        std::ranges::generate(ret, [&] { return randomElement<T>(gen);});
+    }
+    return ret;
+}
+
+/** Runs trials on the element type selected by the user. Records are
+    sorted by their key, signed and floating-point keys by their normalized
+    key, and strings by their first 8 bytes, with the strings that share
+    them sorted by comparison afterwards.
+
+    @param in - the user input to be used for all trials.
+*/
+void
+runReps (Input &in)
+{
+    switch(in.element)
+    {
+        case ElementType::U64: runReps<std::uint64_t>(in, std::identity{}); break;
+        case ElementType::Record: runReps<Record>(in, &Record::key); break;
+        case ElementType::Record32: runReps<Record32>(in, &Record32::key); break;
+        case ElementType::Record64: runReps<Record64>(in, &Record64::key); break;
+        case ElementType::Record256: runReps<Record256>(in, &Record256::key); break;
+        case ElementType::I32: runReps<std::int32_t>(in, NormalizedKey{}); break;
+        case ElementType::I64: runReps<std::int64_t>(in, NormalizedKey{}); break;
+        case ElementType::F32: runReps<float>(in, NormalizedKey{}); break;
+        case ElementType::F64: runReps<double>(in, NormalizedKey{}); break;
+        case ElementType::String16: runReps<String16>(in, NormalizedKey{}); break;
+        default: runReps<uint>(in, std::identity{}); break;
+    }
+}
+
+/** Runs trials according to user specified traits
+
+    @param in - the user input to be used for all trials.
+
+    NOTE: This method will generate the following:
+    1) in.trials * in.reps vectors of size in.vecSize
+    2) # of sorts being run copies of the vectors in 1)
+    3) in.trials * in.reps * # of sorts {sort, time} pairs
+    over the duration of its runtime.
+
+    NOTE: radix sort does not compare elements, so the pt, pv and ss flags
+    are ignored. Buckets at or below the cutoff are insertion sorted, and
+    the last column is the memory used by the distribution buffers.
+
+    @param keyOf - extracts the unsigned key of an element
+*/
+template<typename T, typename KeyOf>
+void
+runReps (Input &in, KeyOf keyOf)
+{
+    std::ofstream file(in.filename, std::ios::app);
+
+    for(uint i = 0; i < in.reps; ++i)
+    {
+        std::vector<T> data(in.vecSize);
+        data = generateTestData<T> (in.vecSize, in.seed);
+        limitDistinct(data.begin(), data.end(), in.distinct);
+        arrangeRuns(data.begin(), data.end(), in.runs, ProjectedLess<std::ranges::less, KeyOf>{{}, keyOf});
+
+        std::size_t extraBytes = 0;
+        double time = timeAlgorithm([&] {
+            BS::thread_pool threads(in.threads);
+            std::size_t threadCount = threads.get_thread_count();
+            msdRadixSort(data.begin(), data.end(), keyOf, in.cutoff, threadCount, [&threads] (std::size_t count, const auto &f) {
+                for(std::size_t i = 0; i < count; ++i) { threads.push_task([&f, i] {f(i);}); }
+                threads.wait_for_tasks();
+            });
+            if constexpr (isFixedString<T>) { sortEqualPrefixes(data.begin(), data.end()); }
+            //a single thread only runs the American flag sort, which has no buffers
+            extraBytes = threadCount > 1 ? distributionExtraBytes<T>(threadCount, MSD_RADIX) : 0;
+        });
+
+        std::string output = std::format("{},{},{},{},{},{},{},{},{},{},{}\n", "MSD Radix", time, in.vecSize, "msd8", "none", 0, "insertion", elementNames[static_cast<int>(in.element)], extraBytes, 0, in.runs);
+        file.write(output.c_str(), output.length());
+    }
+}
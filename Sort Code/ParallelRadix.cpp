@@ -0,0 +1,188 @@
+/*
+Filename    : ParallelRadix.cpp
+Author      : Peter Freedman
+Course      : CSCI 476
+Assignment  : CSCI 476 - Final Project
+Description : Generates the ParallelRadixSort executable, an LSD radix sort
+    of the unsigned integer keys on std::jthreads. Each thread counts and
+    scatters one chunk of the array with its own histogram.
+*/
+
+/************************************************************/
+// System includes
+#include <iostream>
+#include <concepts>
+
+#include <random>
+#include <algorithm>
+
+#include <thread>
+/************************************************************/
+// Local includes
+#include "../CLInterpret.cpp"
+#include "../included/Timer.hpp"
+#include "../included/Ordering.hpp"
+#include "../included/KeyNormalization.hpp"
+#include "../included/RadixSort.hpp"
+
+
+
+/************************************************************/
+// Using declarations
+
+template<typename Callable>
+concept callable = std::invocable<Callable>;
+
+/************************************************************/
+// Function prototypes/global vars/type definitions
+
+template<callable Function>
+double
+timeAlgorithm (const Function &f);
+
+template<typename T>
+std::vector<T>
+generateTestData(const unsigned size, const unsigned seed);
+
+void
+runReps (Input &in);
+
+template<typename T, typename KeyOf>
+void
+runReps (Input &in, KeyOf keyOf);
+/************************************************************/
+
+int
+main (int argc, char* argv[])
+{
+    Input in = compileInput(argc, argv);
+    runReps(in);
+}
+
+/** Times the algorithm passed in as a parameter
+
+    @param f - the function to time
+    @return - the time the function took to execute, as a double
+*/
+template<callable Function>
+double
+timeAlgorithm (const Function &f)
+{
+    Timer t;
+    f();
+    t.stop();
+    return t.getElapsedMs();
+}
+
+/** Generates a vector of random elements of type T. uints are drawn from
+    the original 32-bit generator, everything else from randomElement.
+
+    @param size - the size of the vector to be generated
+
+    @return - a vector of size @p size full of elements in the range [0, 100'000'000)
+
+    NOTE: The random numbers generated by this method will be in the same order between
+    executions.
+*/
+template<typename T>
+std::vector<T>
+generateTestData(const unsigned size, const unsigned seed)
+{
+    std::vector<T> ret(size);
+    if constexpr (std::is_same_v<T, uint>)
+    {
+        static std::mt19937 gen{seed};
+        std::ranges::generate(ret, [&] { return gen();});
+    }
+    else {
+        static std::mt19937_64 gen{seed};
+        std::ranges::generate(ret, [&] { return randomElement<T>(gen);});
+    }
+    return ret;
+}
+
+/** Runs trials on the element type selected by the user. Records are
+    sorted by their key, signed and floating-point keys by their normalized
+    key, and strings are skipped as they are wider than any integer key.
+
+    @param in - the user input to be used for all trials.
+*/
+void
+runReps (Input &in)
+{
+    switch(in.element)
+    {
+        case ElementType::U64: runReps<std::uint64_t>(in, std::identity{}); break;
+        case ElementType::Record: runReps<Record>(in, &Record::key); break;
+        case ElementType::Record32: runReps<Record32>(in, &Record32::key); break;
+        case ElementType::Record64: runReps<Record64>(in, &Record64::key); break;
+        case ElementType::Record256: runReps<Record256>(in, &Record256::key); break;
+        case ElementType::I32: runReps<std::int32_t>(in, NormalizedKey{}); break;
+        case ElementType::I64: runReps<std::int64_t>(in, NormalizedKey{}); break;
+        case ElementType::F32: runReps<float>(in, NormalizedKey{}); break;
+        case ElementType::F64: runReps<double>(in, NormalizedKey{}); break;
+        case ElementType::String16:
+            std::cerr << "ParallelRadixSort needs keys of at most 64 bits, skipping str16.\n";
+            break;
+        default: runReps<uint>(in, std::identity{}); break;
+    }
+}
+
+/** Runs trials according to user specified traits
+
+    @param in - the user input to be used for all trials.
+
+    NOTE: This method will generate the following:
+    1) in.trials * in.reps vectors of size in.vecSize
+    2) # of sorts being run copies of the vectors in 1)
+    3) in.trials * in.reps * # of sorts {sort, time} pairs
+    over the duration of its runtime.
+
+    NOTE: radix sort does not compare elements, so the ct, pt, pv and ss
+    flags are ignored. The time includes allocating the second buffer, and
+    the last column is the memory used besides the array itself.
+
+    @param keyOf - extracts the unsigned key of an element
+*/
+template<typename T, typename KeyOf>
+void
+runReps (Input &in, KeyOf keyOf)
+{
+    if(in.digitBits != 8 && in.digitBits != 11)
+    {
+        std::cerr << std::format("The digit width must be 8 or 11, not {}.\n", in.digitBits);
+        exit(EXIT_FAILURE);
+    }
+
+    std::ofstream file(in.filename, std::ios::app);
+    using Key = RadixKey<T, KeyOf>;
+
+    std::size_t chunks = in.threads > 0 ? in.threads : std::max(1u, std::thread::hardware_concurrency());
+    auto forEach = [] (std::size_t count, const auto &f) {
+        std::vector<std::jthread> workers;
+        for(std::size_t i = 1; i < count; ++i)
+        {
+            workers.emplace_back(f, i);
+        }
+        f(0);
+    };
+
+    for(uint i = 0; i < in.reps; ++i)
+    {
+        std::vector<T> data(in.vecSize);
+        data = generateTestData<T> (in.vecSize, in.seed);
+        limitDistinct(data.begin(), data.end(), in.distinct);
+        arrangeRuns(data.begin(), data.end(), in.runs, ProjectedLess<std::ranges::less, KeyOf>{{}, keyOf});
+
+        double time = timeAlgorithm([&] {
+            std::vector<T> buffer(data.size());
+            if(in.digitBits == 11) { lsdRadixSort<11>(data.begin(), data.end(), buffer.begin(), keyOf, chunks, forEach); }
+            else { lsdRadixSort<8>(data.begin(), data.end(), buffer.begin(), keyOf, chunks, forEach); }
+        });
+        std::size_t extraBytes = in.digitBits == 11 ? radixExtraBytes<T, Key, 11>(data.size(), chunks)
+                                                    : radixExtraBytes<T, Key, 8>(data.size(), chunks);
+
+        std::string output = std::format("{},{},{},lsd{},{},{},{},{},{},{},{}\n", "Parallel Radix", time, in.vecSize, in.digitBits, "none", 0, "none", elementNames[static_cast<int>(in.element)], extraBytes, 0, in.runs);
+        file.write(output.c_str(), output.length());
+    }
+}
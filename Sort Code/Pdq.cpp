@@ -0,0 +1,525 @@
+/*
+Filename    : Pdq.cpp
+Author      : Peter Freedman
+Course      : CSCI 476
+Assignment  : CSCI 476 - Final Project
+Description : Generates the PdqSort executable, a serial pattern-defeating
+    quicksort (after Orson Peters' pdqsort). It detects ranges that are
+    already partitioned, finishes nearly sorted ranges with a bounded
+    insertion sort, and shuffles elements after badly unbalanced partitions
+    to break up adversarial patterns, falling back to heapsort if that
+    keeps happening.
+*/
+
+/************************************************************/
+// System includes
+#include <iostream>
+#include <concepts>
+
+#include <random>
+#include <algorithm>
+
+/************************************************************/
+// Local includes
+#include "../CLInterpret.cpp"
+#include "../included/Timer.hpp"
+#include "../included/Introsort.hpp"
+#include "../included/Ordering.hpp"
+
+
+
+/************************************************************/
+// Using declarations
+
+template<typename Callable>
+concept callable = std::invocable<Callable>;
+
+template <typename Iter>
+concept random_access = std::random_access_iterator<Iter>;
+
+/************************************************************/
+// Function prototypes/global vars/type definitions
+
+//ranges larger than this use Tukey's ninther instead of median-of-3
+const static int NINTHER_THRESHOLD = 128;
+
+//the number of element moves after which partialInsertionSort gives up
+const static int PARTIAL_INSERTION_LIMIT = 8;
+
+template<callable Function>
+double
+timeAlgorithm (const Function &f);
+
+template<typename T>
+std::vector<T>
+generateTestData(const unsigned size, const unsigned seed);
+
+void
+runReps (Input &in);
+
+template<typename T, typename Comp, typename Proj>
+void
+runReps (Input &in, Comp comp, Proj proj);
+
+template <random_access Iter, typename Compare>
+void
+insertionSort (Iter first, Iter last, Compare less);
+
+template <random_access Iter, typename Compare>
+void
+unguardedInsertionSort (Iter first, Iter last, Compare less);
+
+template <random_access Iter, typename Compare>
+bool
+partialInsertionSort (Iter first, Iter last, Compare less);
+
+template <random_access Iter, typename Compare>
+void
+sort3 (Iter a, Iter b, Iter c, Compare less);
+
+template <random_access Iter, typename Compare>
+std::pair<Iter, bool>
+partitionRight (Iter begin, Iter end, Compare less);
+
+template <random_access Iter, typename Compare>
+Iter
+partitionLeft (Iter begin, Iter end, Compare less);
+
+template <random_access Iter, typename Compare>
+void
+pdqSort (Iter begin, Iter end, uint cutoff, Compare less);
+
+template <random_access Iter, typename Compare>
+void
+pdqSort (Iter begin, Iter end, uint cutoff, uint badAllowed, bool leftmost, Compare less);
+/************************************************************/
+
+int
+main (int argc, char* argv[])
+{
+    Input in = compileInput(argc, argv);
+    runReps(in);
+}
+
+/** Times the algorithm passed in as a parameter
+
+    @param f - the function to time
+    @return - the time the function took to execute, as a double
+*/
+template<callable Function>
+double
+timeAlgorithm (const Function &f)
+{
+    Timer t;
+    f();
+    t.stop();
+    return t.getElapsedMs();
+}
+
+/** Generates a vector of random elements of type T. uints are drawn from
+    the original 32-bit generator, everything else from randomElement.
+
+    @param size - the size of the vector to be generated
+
+    @return - a vector of size @p size full of elements in the range [0, 100'000'000)
+
+    NOTE: The random numbers generated by this method will be in the same order between
+    executions.
+*/
+template<typename T>
+std::vector<T>
+generateTestData(const unsigned size, const unsigned seed)
+{
+    std::vector<T> ret(size);
+    if constexpr (std::is_same_v<T, uint>)
+    {
+        static std::mt19937 gen{seed};
+        std::ranges::generate(ret, [&] { return gen();});
+    }
+    else {
+        static std::mt19937_64 gen{seed};
+        std::ranges::generate(ret, [&] { return randomElement<T>(gen);});
+    }
+    return ret;
+}
+
+/** Runs trials on the element type selected by the user. Records are
+    ordered by their key.
+
+    @param in - the user input to be used for all trials.
+*/
+void
+runReps (Input &in)
+{
+    switch(in.element)
+    {
+        case ElementType::U64: runReps<std::uint64_t>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::F64: runReps<double>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::I32: runReps<std::int32_t>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::I64: runReps<std::int64_t>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::F32: runReps<float>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::String16: runReps<String16>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::Record: runReps<Record>(in, std::ranges::less{}, &Record::key); break;
+        case ElementType::Record32: runReps<Record32>(in, std::ranges::less{}, &Record32::key); break;
+        case ElementType::Record64: runReps<Record64>(in, std::ranges::less{}, &Record64::key); break;
+        case ElementType::Record256: runReps<Record256>(in, std::ranges::less{}, &Record256::key); break;
+        default: runReps<uint>(in, std::ranges::less{}, std::identity{}); break;
+    }
+}
+
+/** Runs trials according to user specified traits
+
+    @param in - the user input to be used for all trials.
+
+    NOTE: This method will generate the following:
+    1) in.trials * in.reps vectors of size in.vecSize
+    2) # of sorts being run copies of the vectors in 1)
+    3) in.trials * in.reps * # of sorts {sort, time} pairs
+    over the duration of its runtime.
+
+    NOTE: pdqSort always uses its own partition and pivot selection, so
+    the pt, pv and ss flags are ignored and the CSV records what actually ran.
+
+    @param comp - the comparator to sort with
+    @param proj - the projection applied to each element before comparing
+*/
+template<typename T, typename Comp, typename Proj>
+void
+runReps (Input &in, Comp comp, Proj proj)
+{
+    std::ofstream file(in.filename, std::ios::app);
+    ProjectedLess<Comp, Proj> less{comp, proj};
+
+    for(uint i = 0; i < in.reps; ++i)
+    {
+        std::vector<T> data(in.vecSize);
+        data = generateTestData<T> (in.vecSize, in.seed);
+        limitDistinct(data.begin(), data.end(), in.distinct);
+        arrangeRuns(data.begin(), data.end(), in.runs, less);
+
+        heapsortFallbacks = 0;
+        double time = timeAlgorithm([&] {
+            pdqSort(data.begin(), data.end(), in.cutoff, less);
+        });
+
+        std::string output = std::format("{},{},{},{},{},{},{},{},{},{},{}\n", "Pdq", time, in.vecSize, "pdq", "ninther", heapsortFallbacks.load(), "insertion", elementNames[static_cast<int>(in.element)], 0, 0, in.runs);
+        file.write(output.c_str(), output.length());
+    }
+}
+
+/** Sorts the range [first, last) using insertion sort.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param less - the ordering to sort by
+*/
+template <random_access Iter, typename Compare>
+void
+insertionSort (Iter first, Iter last, Compare less)
+{
+    if(std::distance(first, last) < 2) { return; }
+
+    Iter prev;
+    for(Iter cur = std::next(first); cur != last; ++cur)
+    {
+        //move the current value out
+        auto key = std::move(*cur);
+        prev = std::prev(cur);
+        while (std::distance (first, prev) >= 0 && less(key, *prev))
+        {
+            //move the value of prev up one
+            *(std::next(prev)) = std::move(*prev);
+            //decrement prev
+           --prev;
+        }
+        *(std::next(prev)) = std::move(key);
+    }
+}
+
+/** Sorts the range [first, last) using insertion sort without checking
+    for the start of the range.
+
+    NOTE: the element before first must not be greater than any element in
+    the range, as it is what stops the inner loop.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param less - the ordering to sort by
+*/
+template <random_access Iter, typename Compare>
+void
+unguardedInsertionSort (Iter first, Iter last, Compare less)
+{
+    if(std::distance(first, last) < 2) { return; }
+
+    for(Iter cur = std::next(first); cur != last; ++cur)
+    {
+        auto key = std::move(*cur);
+        Iter hole = cur;
+        while (less(key, *std::prev(hole)))
+        {
+            *hole = std::move(*std::prev(hole));
+            --hole;
+        }
+        *hole = std::move(key);
+    }
+}
+
+/** Attempts to insertion sort [first, last), giving up once more than
+    PARTIAL_INSERTION_LIMIT elements have been moved.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param less - the ordering to sort by
+
+    @return - true if the range is now sorted, false if it gave up
+*/
+template <random_access Iter, typename Compare>
+bool
+partialInsertionSort (Iter first, Iter last, Compare less)
+{
+    if(std::distance(first, last) < 2) { return true; }
+
+    int moved = 0;
+    for(Iter cur = std::next(first); cur != last; ++cur)
+    {
+        if(!less(*cur, *std::prev(cur))) { continue; }
+
+        auto key = std::move(*cur);
+        Iter hole = cur;
+        do {
+            *hole = std::move(*std::prev(hole));
+            --hole;
+        } while (hole != first && less(key, *std::prev(hole)));
+        *hole = std::move(key);
+
+        moved += std::distance(hole, cur);
+        if(moved > PARTIAL_INSERTION_LIMIT) { return false; }
+    }
+    return true;
+}
+
+/** Sorts the three elements a, b and c such that *a <= *b <= *c under less. */
+template <random_access Iter, typename Compare>
+void
+sort3 (Iter a, Iter b, Iter c, Compare less)
+{
+    if(less(*b, *a)) { std::iter_swap(a, b); }
+    if(less(*c, *b)) { std::iter_swap(b, c); }
+    if(less(*b, *a)) { std::iter_swap(a, b); }
+}
+
+/** Partitions [begin, end) around the pivot *begin, such that elements
+    equal to the pivot go to the right.
+
+    NOTE: requires that some element after begin is not less than the pivot,
+    which the median-of-3 in pdqSort guarantees.
+
+    @param begin - the start of the range to partition, holding the pivot
+    @param end - one past the end of the range to partition
+    @param less - the ordering to partition by
+
+    @return - the final position of the pivot, and whether the range was
+        already partitioned (no elements had to be swapped)
+*/
+template <random_access Iter, typename Compare>
+std::pair<Iter, bool>
+partitionRight (Iter begin, Iter end, Compare less)
+{
+    auto pivot = std::move(*begin);
+    Iter first = begin;
+    Iter last = end;
+
+    //find the first element that is not less than the pivot, which exists
+    while (less(*++first, pivot));
+
+    //find the last element that is less than the pivot. If nothing before
+    //first was less than the pivot, this search has to be guarded.
+    if(std::prev(first) == begin)
+    {
+        while (first < last && !less(*--last, pivot));
+    }
+    else {
+        while (!less(*--last, pivot));
+    }
+
+    //if the searches met, there was nothing to swap
+    bool alreadyPartitioned = first >= last;
+
+    //the elements found above act as sentinels for the unguarded searches
+    while (first < last)
+    {
+        std::iter_swap(first, last);
+        while (less(*++first, pivot));
+        while (!less(*--last, pivot));
+    }
+
+    Iter pivotPos = std::prev(first);
+    *begin = std::move(*pivotPos);
+    *pivotPos = std::move(pivot);
+
+    return {pivotPos, alreadyPartitioned};
+}
+
+/** Partitions [begin, end) around the pivot *begin, such that elements
+    equal to the pivot go to the left. Used when the pivot equals the
+    element before the range, in which case every element equal to it is
+    already in its final place.
+
+    @param begin - the start of the range to partition, holding the pivot
+    @param end - one past the end of the range to partition
+    @param less - the ordering to partition by
+
+    @return - the final position of the pivot
+*/
+template <random_access Iter, typename Compare>
+Iter
+partitionLeft (Iter begin, Iter end, Compare less)
+{
+    auto pivot = std::move(*begin);
+    Iter first = begin;
+    Iter last = end;
+
+    while (less(pivot, *--last));
+
+    if(std::next(last) == end)
+    {
+        while (first < last && !less(pivot, *++first));
+    }
+    else {
+        while (!less(pivot, *++first));
+    }
+
+    while (first < last)
+    {
+        std::iter_swap(first, last);
+        while (less(pivot, *--last));
+        while (!less(pivot, *++first));
+    }
+
+    *begin = std::move(*last);
+    *last = std::move(pivot);
+
+    return last;
+}
+
+/** Performs a serial pattern-defeating quicksort on the range [begin, end),
+    switching to insertion sort on smaller sample sizes.
+
+    @param begin - the start of the range to be sorted
+    @param end - the end (exclusive) of the range to be sorted
+    @param cutoff - the point at which insertion sort should be used instead
+    @param less - the ordering to sort by
+*/
+template <random_access Iter, typename Compare>
+void
+pdqSort (Iter begin, Iter end, uint cutoff, Compare less)
+{
+    //the pivot selection below needs at least three elements
+    pdqSort(begin, end, std::max(cutoff, 2u), depthBudget(std::distance(begin, end)) / 2, true, less);
+}
+
+/** The recursive part of pdqSort. Recurses into the left side and loops on
+    the right one.
+
+    @param begin - the start of the range to be sorted
+    @param end - the end (exclusive) of the range to be sorted
+    @param cutoff - the point at which insertion sort should be used instead
+    @param badAllowed - the number of highly unbalanced partitions left
+        before the range is heapsorted instead
+    @param leftmost - whether this is the leftmost range, in which case
+        there is no smaller element before begin to act as a sentinel
+    @param less - the ordering to sort by
+*/
+template <random_access Iter, typename Compare>
+void
+pdqSort (Iter begin, Iter end, uint cutoff, uint badAllowed, bool leftmost, Compare less)
+{
+    while (true)
+    {
+        auto size = std::distance(begin, end);
+        if(size <= cutoff)
+        {
+            if(leftmost) { insertionSort(begin, end, less); }
+            else { unguardedInsertionSort(begin, end, less); }
+            return;
+        }
+
+        //move the chosen pivot to begin
+        auto half = size / 2;
+        if(size > NINTHER_THRESHOLD)
+        {
+            sort3(begin, begin + half, std::prev(end), less);
+            sort3(begin + 1, begin + (half - 1), end - 2, less);
+            sort3(begin + 2, begin + (half + 1), end - 3, less);
+            sort3(begin + (half - 1), begin + half, begin + (half + 1), less);
+            std::iter_swap(begin, begin + half);
+        }
+        else {
+            sort3(begin + half, begin, std::prev(end), less);
+        }
+
+        //if the pivot equals the element before the range, every element
+        //equal to it is already in place, so only the greater ones are left
+        if(!leftmost && !less(*std::prev(begin), *begin))
+        {
+            begin = std::next(partitionLeft(begin, end, less));
+            continue;
+        }
+
+        auto [pivotPos, alreadyPartitioned] = partitionRight(begin, end, less);
+
+        auto leftSize = std::distance(begin, pivotPos);
+        auto rightSize = std::distance(std::next(pivotPos), end);
+        bool unbalanced = leftSize < size / 8 || rightSize < size / 8;
+
+        if(unbalanced)
+        {
+            if(--badAllowed == 0)
+            {
+                heapsortFallback(begin, end, less);
+                return;
+            }
+
+            //swap a few elements from the ends towards the middle to break
+            //up patterns that keep producing bad pivots. Sides at or below the
+            //cutoff will not be partitioned again, so they are left alone.
+            if(leftSize > cutoff && leftSize >= 4)
+            {
+                std::iter_swap(begin, begin + leftSize / 4);
+                std::iter_swap(pivotPos - 1, pivotPos - leftSize / 4);
+                if(leftSize > NINTHER_THRESHOLD)
+                {
+                    std::iter_swap(begin + 1, begin + (leftSize / 4 + 1));
+                    std::iter_swap(begin + 2, begin + (leftSize / 4 + 2));
+                    std::iter_swap(pivotPos - 2, pivotPos - (leftSize / 4 + 1));
+                    std::iter_swap(pivotPos - 3, pivotPos - (leftSize / 4 + 2));
+                }
+            }
+            if(rightSize > cutoff && rightSize >= 4)
+            {
+                std::iter_swap(pivotPos + 1, pivotPos + (1 + rightSize / 4));
+                std::iter_swap(end - 1, end - rightSize / 4);
+                if(rightSize > NINTHER_THRESHOLD)
+                {
+                    std::iter_swap(pivotPos + 2, pivotPos + (2 + rightSize / 4));
+                    std::iter_swap(pivotPos + 3, pivotPos + (3 + rightSize / 4));
+                    std::iter_swap(end - 2, end - (1 + rightSize / 4));
+                    std::iter_swap(end - 3, end - (2 + rightSize / 4));
+                }
+            }
+        }
+        //a balanced partition that moved nothing suggests the range is
+        //nearly sorted, so try to finish both sides cheaply
+        else if(alreadyPartitioned
+            && partialInsertionSort(begin, pivotPos, less)
+            && partialInsertionSort(std::next(pivotPos), end, less))
+        {
+            return;
+        }
+
+        pdqSort(begin, pivotPos, cutoff, badAllowed, leftmost, less);
+        begin = std::next(pivotPos);
+        leftmost = false;
+    }
+}
@@ -21,6 +21,18 @@ Description : This file was modified to generate all of the executables
 // Local includes
 #include "../CLInterpret.cpp"
 #include "../included/Timer.hpp"
+#include "../included/BlockPartition.hpp"
+#include "../included/SimdPartition.hpp"
+#include "../included/StableSort.hpp"
+#include "../included/Cardinality.hpp"
+#include "../included/PivotPolicies.hpp"
+#include "../included/Introsort.hpp"
+#include "../included/MultiPivot.hpp"
+#include "../included/SmallSort.hpp"
+#include "../included/FinishingPass.hpp"
+#include "../included/IterativeQuickSort.hpp"
+#include "../included/Specialization.hpp"
+#include "../included/Ordering.hpp"
 
 
 
@@ -33,6 +45,33 @@ concept callable = std::invocable<Callable>;
 template <typename Iter>
 concept random_access = std::random_access_iterator<Iter>;
 
+//the kernels this build is specialized with. The Makefile builds one
+//executable per variant: RAW_POINTERS sorts through the pointers behind the
+//vector's iterators, TRIVIAL_SHIFT shifts trivially copyable elements with
+//memmove in insertion sort, and FIXED_CUTOFF makes the cutoff a template
+//parameter
+#ifdef RAW_POINTERS
+const static bool rawPointers = true;
+#else
+const static bool rawPointers = false;
+#endif
+
+#ifdef TRIVIAL_SHIFT
+const static bool trivialShift = true;
+#else
+const static bool trivialShift = false;
+#endif
+
+#ifdef FIXED_CUTOFF
+const static bool fixedCutoff = true;
+#else
+const static bool fixedCutoff = false;
+#endif
+
+//the name the rows of this build are written under
+const static std::string sortName = std::string("Serial") + (rawPointers ? " Pointer" : "")
+    + (trivialShift ? " Shift" : "") + (fixedCutoff ? " Fixed" : "");
+
 /************************************************************/
 // Function prototypes/global vars/type definitions
 
@@ -40,23 +79,52 @@ template<callable Function>
 double 
 timeAlgorithm (const Function &f);
 
-std::vector<uint>
+template<typename Function>
+void
+withPivot (const Input &in, const Function &f);
+
+template<typename Function>
+void
+withCutoff (const Input &in, const Function &f);
+
+template<typename T>
+std::vector<T>
 generateTestData(const unsigned size, const unsigned seed);
 
 void
 runReps (Input &in);
 
-template <random_access Iter>
+template<typename T, typename Comp, typename Proj>
+void
+runReps (Input &in, Comp comp, Proj proj);
+
+template <random_access Iter, typename Compare>
+void
+insertionSort (Iter first, Iter last, Compare less);
+
+template <random_access Iter, typename Cutoff, typename Compare>
 void
-insertionSort (Iter first, Iter last);
+smallSort (Iter first, Iter last, Cutoff cutoff, SmallSort leaf, Compare less);
 
-template<random_access Iter, typename Value>
+template<random_access Iter, typename Value, typename Compare>
 std::pair<Iter, Iter>
-partition (Iter begin, Iter end, Value pivot);
+partition (Iter begin, Iter end, const Value &pivot, Compare less);
+
+template<random_access Iter, typename Value, typename Compare>
+std::pair<Iter, Iter>
+partition (Iter begin, Iter end, const Value &pivot, Scheme scheme, Compare less);
+
+template<random_access Iter, typename Compare>
+Segments<Iter>
+partition (Iter begin, Iter end, Scheme scheme, Compare less);
 
-template <random_access Iter>
+template <random_access Iter, typename Cutoff, typename Pivot, typename Compare>
 void
-quickSort (Iter begin, Iter end, uint cutoff);
+quickSort (Iter begin, Iter end, Cutoff cutoff, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Compare less);
+
+template <random_access Iter, typename Cutoff, typename Pivot, typename Compare>
+void
+iterativeQuickSort (Iter begin, Iter end, Cutoff cutoff, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Compare less);
 /************************************************************/
 
 int
@@ -81,7 +149,46 @@ timeAlgorithm (const Function &f)
     return t.getElapsedMs();
 }
 
-/** Generates a vector of random uints in the range [0,UNSIGNED_MAX)
+/** Calls f with the pivot policy selected by the user.
+
+    @param in - the user input holding the pivot policy and sample size
+    @param f - the function to call with the policy object
+*/
+template<typename Function>
+void
+withPivot (const Input &in, const Function &f)
+{
+    switch(in.pivot)
+    {
+        case PivotRule::MedianOf3: f(MedianOf3Pivot{}); break;
+        case PivotRule::Ninther: f(NintherPivot{}); break;
+        case PivotRule::Random: f(RandomPivot{}); break;
+        case PivotRule::Sample: f(SampleMedianPivot{in.sampleSize}); break;
+        default: f(FirstPivot{}); break;
+    }
+}
+
+/** Calls f with the cutoff given by the user. Builds with a fixed cutoff
+    pass it as a FixedCutoff when it is one of FixedCutoffs, and as a
+    number otherwise, like every other build.
+
+    @param in - the user input holding the cutoff
+    @param f - the function to call with the cutoff
+*/
+template<typename Function>
+void
+withCutoff (const Input &in, const Function &f)
+{
+    if constexpr (fixedCutoff)
+    {
+        if(withFixedCutoff(in.cutoff, f)) { return; }
+        std::cout << std::format("{} has no fixed cutoff of {}, using it at run time.\n", sortName, in.cutoff);
+    }
+    f(in.cutoff);
+}
+
+/** Generates a vector of random elements of type T. uints are drawn from
+    the original 32-bit generator, everything else from randomElement.
 
     @param size - the size of the vector to be generated
     
@@ -90,15 +197,47 @@ timeAlgorithm (const Function &f)
     NOTE: The random numbers generated by this method will be in the same order between
     executions.
 */
-std::vector<uint>
+template<typename T>
+std::vector<T>
 generateTestData(const unsigned size, const unsigned seed)
 {
-    std::vector<uint> ret(size);
-    static std::mt19937 gen{seed};
-    std::ranges::generate(ret, [&] { return gen();});
+    std::vector<T> ret(size);
+    if constexpr (std::is_same_v<T, uint>)
+    {
+        static std::mt19937 gen{seed};
+        std::ranges::generate(ret, [&] { return gen();});
+    }
+    else {
+        static std::mt19937_64 gen{seed};
+        std::ranges::generate(ret, [&] { return randomElement<T>(gen);});
+    }
     return ret;
 }
 
+/** Runs trials on the element type selected by the user. Records are
+    ordered by their key.
+
+    @param in - the user input to be used for all trials.
+*/
+void
+runReps (Input &in)
+{
+    switch(in.element)
+    {
+        case ElementType::U64: runReps<std::uint64_t>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::F64: runReps<double>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::I32: runReps<std::int32_t>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::I64: runReps<std::int64_t>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::F32: runReps<float>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::String16: runReps<String16>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::Record: runReps<Record>(in, std::ranges::less{}, &Record::key); break;
+        case ElementType::Record32: runReps<Record32>(in, std::ranges::less{}, &Record32::key); break;
+        case ElementType::Record64: runReps<Record64>(in, std::ranges::less{}, &Record64::key); break;
+        case ElementType::Record256: runReps<Record256>(in, std::ranges::less{}, &Record256::key); break;
+        default: runReps<uint>(in, std::ranges::less{}, std::identity{}); break;
+    }
+}
+
 /** Runs trials according to user specified traits
 
     @param in - the user input to be used for all trials.
@@ -111,22 +250,48 @@ generateTestData(const unsigned size, const unsigned seed)
 
     NOTE: for the sake of readability, if no CSV is generated, only 
     the data from the first 5 reps will be printed.
+
+    @param comp - the comparator to sort with
+    @param proj - the projection applied to each element before comparing
 */
+template<typename T, typename Comp, typename Proj>
 void
-runReps (Input &in)
+runReps (Input &in, Comp comp, Proj proj)
 {
     std::ofstream file(in.filename, std::ios::app);
+    ProjectedLess<Comp, Proj> less{comp, proj};
 
     for(uint i = 0; i < in.reps; ++i)
     {
-        std::vector<unsigned> data(in.vecSize);
-        data = generateTestData (in.vecSize, in.seed);
-
-        double time = timeAlgorithm([&] {
-            quickSort(data.begin(), data.end(), in.cutoff);
-        });
-
-        std::string output = std::format("{},{},{}\n", "Serial", time, in.vecSize);
+        std::vector<T> data(in.vecSize);
+        data = generateTestData<T> (in.vecSize, in.seed);
+        limitDistinct(data.begin(), data.end(), in.distinct);
+        arrangeRuns(data.begin(), data.end(), in.runs, less);
+
+        heapsortFallbacks = 0;
+        maxStackDepth = 0;
+        double time = 0;
+        withPivot(in, [&] (auto pick) { withCutoff(in, [&] (auto cutoff) {
+            auto sortRange = [&] (auto begin, auto end) {
+                if(in.engine == Engine::Iterative)
+                {
+                    iterativeQuickSort(begin, end, cutoff, in.scheme, pick, depthBudget(data.size()), in.smallSort, less);
+                }
+                else {
+                    quickSort(begin, end, cutoff, in.scheme, pick, depthBudget(data.size()), in.smallSort, less);
+                }
+                if(in.smallSort == SmallSort::Deferred)
+                {
+                    finishingPass(begin, end, in.cutoff, less);
+                }
+            };
+            time = timeAlgorithm([&] {
+                if constexpr (rawPointers) { sortRange(rawIterator(data.begin()), rawIterator(data.end())); }
+                else { sortRange(data.begin(), data.end()); }
+            });
+        }); });
+
+        std::string output = std::format("{},{},{},{},{},{},{},{},{},{},{}\n", sortName, time, in.vecSize, schemeNames[static_cast<int>(in.scheme)], pivotNames[static_cast<int>(in.pivot)], heapsortFallbacks.load(), smallSortNames[static_cast<int>(in.smallSort)], elementNames[static_cast<int>(in.element)], 0, maxStackDepth.load(), in.runs);
         file.write(output.c_str(), output.length());
     }
 }
@@ -138,30 +303,56 @@ runReps (Input &in)
     @param numTrials - the number of times to repeat the above process
     @param in - the user input to use as the basis for these trials
 */
-template <random_access Iter>
+template <random_access Iter, typename Compare>
 void
-insertionSort (Iter first, Iter last)
+insertionSort (Iter first, Iter last, Compare less)
 {
+    if constexpr (trivialShift && canShift<Iter>)
+    {
+        shiftInsertionSort(first, last, less);
+        return;
+    }
     if(std::distance(first, last) < 2) { return; }
 
     Iter prev;
-    unsigned key; 
     for(Iter cur = std::next(first); cur != last; ++cur)
     {
-        //store the current value out
-        key = *cur;
+        //move the current value out
+        auto key = std::move(*cur);
         prev = std::prev(cur);
-        while (std::distance (first, prev) >= 0 && *prev > key)
+        while (std::distance (first, prev) >= 0 && less(key, *prev))
         {
-            //copy the value of prev up one
-            *(std::next(prev)) = *prev;
+            //move the value of prev up one
+            *(std::next(prev)) = std::move(*prev);
             //decrement prev
            --prev;
         }
-        *(std::next(prev)) = key;
+        *(std::next(prev)) = std::move(key);
     }
 }
 
+/** Sorts a range below the cutoff with the sort selected by leaf. Ranges
+    the sorting network cannot handle use insertion sort, and deferred
+    ranges are left as they are.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param cutoff - the most elements the range can hold. A FixedCutoff
+        bounds the insertion sort by a constant
+    @param leaf - the small sort to use
+    @param less - the ordering to sort by
+*/
+template <random_access Iter, typename Cutoff, typename Compare>
+void
+smallSort (Iter first, Iter last, [[maybe_unused]] Cutoff cutoff, SmallSort leaf, Compare less)
+{
+    //deferred ranges are sorted by finishingPass once the quicksort is done
+    if(leaf == SmallSort::Deferred) { return; }
+    if(leaf == SmallSort::Network && networkSort(first, last, less)) { return; }
+    if constexpr (isFixedCutoff<Cutoff>) { boundedInsertionSort<Cutoff::value, trivialShift>(first, last, less); }
+    else { insertionSort(first, last, less); }
+}
+
 /** Partitions the range [begin, end) such that all elements less than *pivot 
     come before pivot, all elements equal to *pivot are in the middle, and all
     elements greater than *pivot are after towards the end.
@@ -172,15 +363,16 @@ insertionSort (Iter first, Iter last)
     @param end - one past the end of the range to partition
     @param pivot - an iterator pointing to the value on which the range should 
         be partitioned
+    @param less - the ordering to partition by
     
     @return - a pair such that all elements to the left of pair.first
             are less than pivot, all elements between pair.first and 
             pair.second are equal to pivot, and all elements after
             pair.second are greater than the pivot.
 */
-template<random_access Iter, typename Value>
+template<random_access Iter, typename Value, typename Compare>
 std::pair<Iter, Iter>
-partition (Iter begin, Iter end, Value pivot)
+partition (Iter begin, Iter end, const Value &pivot, Compare less)
 {
     if(std::distance(begin, end) <= 1) { return {begin, end}; }
   
@@ -190,13 +382,13 @@ partition (Iter begin, Iter end, Value pivot)
 
     while (cur < nextHigh)
     {
-        if(*cur < pivot)
+        if(less(*cur, pivot))
         {
             std::iter_swap(cur, nextLow);
             ++nextLow;
             ++cur;
         }
-        else if(*cur > pivot)
+        else if(less(pivot, *cur))
         {
             --nextHigh;
             std::iter_swap(cur, nextHigh);
@@ -207,28 +399,128 @@ partition (Iter begin, Iter end, Value pivot)
     return {nextLow, nextHigh};
 }
 
-/** Performs a dual-pivot serial quicksort on the range [begin, end),
-    switching to insertion sort on smaller sample sizes.
+/** Partitions the range [begin, end) around pivot using the kernel selected
+    by scheme. See partition, blockPartition, simdPartition and
+    stablePartition for the exact contracts. The adaptive scheme uses
+    blockPartition unless pivotRepeats finds copies of the pivot.
+
+    @param begin - the start of the range to partition
+    @param end - one past the end of the range to partition
+    @param pivot - the value on which the range should be partitioned
+    @param scheme - the partitioning kernel to use
+    @param less - the ordering to partition by
+
+    @return - a pair such that all elements to the left of pair.first
+            are less than pivot, all elements between pair.first and
+            pair.second are equal to pivot, and all elements after
+            pair.second are not less than the pivot.
+*/
+template<random_access Iter, typename Value, typename Compare>
+std::pair<Iter, Iter>
+partition (Iter begin, Iter end, const Value &pivot, Scheme scheme, Compare less)
+{
+    if(scheme == Scheme::Block) { return blockPartition(begin, end, pivot, less); }
+    if(scheme == Scheme::Simd) { return simdPartition(begin, end, pivot, less); }
+    if(scheme == Scheme::Stable) { return stablePartition(begin, end, pivot, less); }
+    if(scheme == Scheme::Adaptive && !pivotRepeats(begin, end, pivot, less)) { return blockPartition(begin, end, pivot, less); }
+    return partition(begin, end, pivot, less);
+}
+
+/** Partitions the range [begin, end) with the multi-pivot kernel selected
+    by scheme. See dualPivotPartition and threePivotPartition.
+
+    @param begin - the start of the range to partition
+    @param end - one past the end of the range to partition
+    @param scheme - the partitioning kernel to use, DualPivot or ThreePivot
+    @param less - the ordering to partition by
+
+    @return - the ranges that are left to sort
+*/
+template<random_access Iter, typename Compare>
+Segments<Iter>
+partition (Iter begin, Iter end, Scheme scheme, Compare less)
+{
+    if(scheme == Scheme::ThreePivot) { return threePivotPartition(begin, end, less); }
+    return dualPivotPartition(begin, end, less);
+}
+
+/** Performs a 3-way (or, if scheme asks for it, multi-pivot) serial
+    quicksort on the range [begin, end), switching to insertion sort on
+    smaller sample sizes.
 
     @param begin - the start of the range to be sorted
     @param end - the end (exclusive) of the range to be sorted
-    @param cutoff - the point at which insertion sort should be used instead
+    @param cutoff - the point at which insertion sort should be used instead,
+        a number or a FixedCutoff
+    @param scheme - the partitioning kernel to use
+    @param pick - the pivot policy, called on each range to choose its pivot
+    @param budget - the number of partitioning levels left before the range
+        is heapsorted instead
+    @param leaf - the sort to use on ranges below the cutoff
+    @param less - the ordering to sort by
     @param useOMP - if this is 1, OMP tasks will be used to parallelize the sort
         the default value of this parameter is 0.
 */
-template <random_access Iter>
+template <random_access Iter, typename Cutoff, typename Pivot, typename Compare>
 void
-quickSort (Iter begin, Iter end, uint cutoff)
+quickSort (Iter begin, Iter end, Cutoff cutoff, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Compare less)
 {
-    if(std::distance(begin, end) <= cutoff)
+    if(static_cast<std::size_t>(std::distance(begin, end)) <= cutoff)
     {
-        insertionSort(begin, end);
+        smallSort(begin, end, cutoff, leaf, less);
         return;
     }
-    auto pivot = *begin;
-    auto [lowPivot, hiPivot] = partition(begin, end, pivot);
+    if(budget == 0)
+    {
+        heapsortFallback(begin, end, less);
+        return;
+    }
+    if(scheme == Scheme::DualPivot || scheme == Scheme::ThreePivot)
+    {
+        for(const auto &part : partition(begin, end, scheme, less))
+        {
+            quickSort(part.first, part.second, cutoff, scheme, pick, budget - 1, leaf, less);
+        }
+        return;
+    }
+
+    auto pivot = pick(begin, end, less);
+    auto [lowPivot, hiPivot] = partition(begin, end, pivot, scheme, less);
 
-    quickSort(begin, lowPivot, cutoff);
-    quickSort(hiPivot, end, cutoff);
+    quickSort(begin, lowPivot, cutoff, scheme, pick, budget - 1, leaf, less);
+    quickSort(hiPivot, end, cutoff, scheme, pick, budget - 1, leaf, less);
 }
 
+/** Performs the same sort as quickSort, but keeps the ranges left to sort
+    on the explicit stack of quickSortLoop instead of recursing.
+
+    @param begin - the start of the range to be sorted
+    @param end - the end (exclusive) of the range to be sorted
+    @param cutoff - the point at which the small sort should be used instead,
+        a number or a FixedCutoff
+    @param scheme - the partitioning kernel to use
+    @param pick - the pivot policy, called on each range to choose its pivot
+    @param budget - the number of partitioning levels left before the range
+        is heapsorted instead
+    @param leaf - the sort to use on ranges below the cutoff
+    @param less - the ordering to sort by
+*/
+template <random_access Iter, typename Cutoff, typename Pivot, typename Compare>
+void
+iterativeQuickSort (Iter begin, Iter end, Cutoff cutoff, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Compare less)
+{
+    quickSortLoop(begin, end, cutoff, budget, less,
+        [=] (Iter first, Iter last) { smallSort(first, last, cutoff, leaf, less); },
+        [=] (Iter first, Iter last) {
+            if(scheme == Scheme::DualPivot || scheme == Scheme::ThreePivot)
+            {
+                return partition(first, last, scheme, less);
+            }
+            auto pivot = pick(first, last, less);
+            auto [lowPivot, hiPivot] = partition(first, last, pivot, scheme, less);
+            Segments<Iter> parts;
+            parts.add(first, lowPivot);
+            parts.add(hiPivot, last);
+            return parts;
+        });
+}
@@ -0,0 +1,188 @@
+/*
+Filename    : StringSort.cpp
+Author      : Peter Freedman
+Course      : CSCI 476
+Assignment  : CSCI 476 - Final Project
+Description : Generates the StringSort executable, which sorts generated
+    strings with std::sort, a multikey quicksort and a parallel string
+    samplesort whose threads LCP-merge their pieces, so the cost of
+    comparing shared prefixes over and over can be seen.
+*/
+
+/************************************************************/
+// System includes
+#include <iostream>
+#include <concepts>
+
+#include <random>
+#include <algorithm>
+#include <string>
+
+/************************************************************/
+// Local includes
+#include "../CLInterpret.cpp"
+#include "../included/Timer.hpp"
+#include "../included/Ordering.hpp"
+#include "../included/StringSort.hpp"
+#include "../included/BS_thread_pool.hpp"
+
+
+
+/************************************************************/
+// Using declarations
+
+template<typename Callable>
+concept callable = std::invocable<Callable>;
+
+/************************************************************/
+// Function prototypes/global vars/type definitions
+
+template<callable Function>
+double
+timeAlgorithm (const Function &f);
+
+std::string
+randomLetters (std::mt19937_64 &gen, std::size_t length);
+
+std::vector<std::string>
+generateTestData(const unsigned size, const unsigned seed, StringData kind);
+
+void
+runReps (Input &in);
+/************************************************************/
+
+int
+main (int argc, char* argv[])
+{
+    Input in = compileInput(argc, argv);
+    runReps(in);
+}
+
+/** Times the algorithm passed in as a parameter
+
+    @param f - the function to time
+    @return - the time the function took to execute, as a double
+*/
+template<callable Function>
+double
+timeAlgorithm (const Function &f)
+{
+    Timer t;
+    f();
+    t.stop();
+    return t.getElapsedMs();
+}
+
+/** Makes a string of random lowercase letters.
+
+    @param gen - the 64-bit generator to draw from
+    @param length - the length of the string
+
+    @return - the string
+*/
+std::string
+randomLetters (std::mt19937_64 &gen, std::size_t length)
+{
+    std::string ret(length, 'a');
+    for(char &c : ret) { c = 'a' + gen() % 26; }
+    return ret;
+}
+
+/** Generates a vector of random strings of the kind given.
+    random: 8 to 40 random letters.
+    prefix: one of 16 prefixes of 64 random letters, then 8 random letters,
+        so most of every comparison is spent on the shared prefix.
+    url: "https://", one of 64 hosts, one to four path segments taken from
+        1024 words, and on half of them an "?id=" query.
+
+    @param size - the size of the vector to be generated
+    @param kind - the kind of strings to generate
+
+    @return - a vector of size @p size full of strings
+
+    NOTE: The strings generated by this method will be in the same order between
+    executions. The prefixes, hosts and words are drawn once, on the first call.
+*/
+std::vector<std::string>
+generateTestData(const unsigned size, const unsigned seed, StringData kind)
+{
+    static std::mt19937_64 gen{seed};
+    static std::vector<std::string> prefixes;
+    static std::vector<std::string> hosts;
+    static std::vector<std::string> words;
+    if(prefixes.empty())
+    {
+        const char* tlds[] {".com", ".org", ".net", ".edu"};
+        for(int i = 0; i < 16; ++i) { prefixes.push_back(randomLetters(gen, 64)); }
+        for(int i = 0; i < 64; ++i) { hosts.push_back(std::format("www.{}{}", randomLetters(gen, 4 + gen() % 12), tlds[gen() % 4])); }
+        for(int i = 0; i < 1024; ++i) { words.push_back(randomLetters(gen, 3 + gen() % 10)); }
+    }
+
+    std::vector<std::string> ret(size);
+    std::ranges::generate(ret, [&] {
+        switch(kind)
+        {
+            case StringData::Prefix: return prefixes[gen() % prefixes.size()] + randomLetters(gen, 8);
+            case StringData::Url:
+            {
+                std::string url = "https://" + hosts[gen() % hosts.size()];
+                for(std::size_t s = 1 + gen() % 4; s > 0; --s) { url += "/" + words[gen() % words.size()]; }
+                if(gen() % 2 == 0) { url += std::format("?id={}", gen() % 100'000); }
+                return url;
+            }
+            default: return randomLetters(gen, 8 + gen() % 33);
+        }
+    });
+    return ret;
+}
+
+/** Runs trials according to user specified traits
+
+    @param in - the user input to be used for all trials.
+
+    NOTE: This method will generate the following:
+    1) in.trials * in.reps vectors of size in.vecSize
+    2) # of sorts being run copies of the vectors in 1)
+    3) in.trials * in.reps * # of sorts {sort, time} pairs
+    over the duration of its runtime.
+
+    NOTE: the strings are chosen with the sg flag, not ty, and the element
+    column holds their kind. The pt, pv and ss flags are ignored, and
+    ranges at or below the cutoff are insertion sorted.
+*/
+void
+runReps (Input &in)
+{
+    std::ofstream file(in.filename, std::ios::app);
+    const char* kind = stringDataNames[static_cast<int>(in.strings)];
+
+    for(uint i = 0; i < in.reps; ++i)
+    {
+        std::vector<std::string> data = generateTestData(in.vecSize, in.seed, in.strings);
+        limitDistinct(data.begin(), data.end(), in.distinct);
+        arrangeRuns(data.begin(), data.end(), in.runs, DefaultLess{});
+
+        std::vector<std::string> copy = data;
+        double time = timeAlgorithm([&] { std::sort(copy.begin(), copy.end()); });
+        std::string output = std::format("{},{},{},{},{},{},{},{},{},{},{}\n", "std::sort", time, in.vecSize, "std", "std", 0, "insertion", kind, 0, 0, in.runs);
+        file.write(output.c_str(), output.length());
+
+        copy = data;
+        time = timeAlgorithm([&] { multikeyQuickSort(copy.begin(), copy.end(), in.cutoff); });
+        output = std::format("{},{},{},{},{},{},{},{},{},{},{}\n", "Multikey Quicksort", time, in.vecSize, "mkqs", "median3", 0, "insertion", kind, copy.size(), 0, in.runs);
+        file.write(output.c_str(), output.length());
+
+        std::size_t extraBytes = 0;
+        time = timeAlgorithm([&] {
+            BS::thread_pool threads(in.threads);
+            std::size_t threadCount = threads.get_thread_count();
+            parallelStringSort(data.begin(), data.end(), in.cutoff, threadCount, [&threads] (std::size_t count, const auto &f) {
+                for(std::size_t i = 0; i < count; ++i) { threads.push_task([&f, i] {f(i);}); }
+                threads.wait_for_tasks();
+            });
+            extraBytes = parallelStringSortExtraBytes<std::string>(data.size(), threadCount);
+        });
+        output = std::format("{},{},{},{},{},{},{},{},{},{},{}\n", "String Samplesort", time, in.vecSize, "lcp-merge", "sample", 0, "insertion", kind, extraBytes, 0, in.runs);
+        file.write(output.c_str(), output.length());
+    }
+}
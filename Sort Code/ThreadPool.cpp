@@ -16,12 +16,28 @@ Description : This file was modified to generate all of the executables
 
 #include <random> 
 #include <algorithm>
+#include <atomic>
+#include <memory>
 
 
 /************************************************************/
 // Local includes
 #include "../CLInterpret.cpp"
 #include "../included/Timer.hpp"
+#include "../included/BlockPartition.hpp"
+#include "../included/SimdPartition.hpp"
+#include "../included/StableSort.hpp"
+#include "../included/Cardinality.hpp"
+#include "../included/PivotPolicies.hpp"
+#include "../included/Introsort.hpp"
+#include "../included/MultiPivot.hpp"
+#include "../included/SmallSort.hpp"
+#include "../included/FinishingPass.hpp"
+#include "../included/IterativeQuickSort.hpp"
+#include "../included/ParallelPartition.hpp"
+#include "../included/Selection.hpp"
+#include "../included/Ordering.hpp"
+#include "../included/KeyNormalization.hpp"
 #include "../included/BS_thread_pool.hpp"
 
 
@@ -38,31 +54,68 @@ concept random_access = std::random_access_iterator<Iter>;
 /************************************************************/
 // Function prototypes/global vars/type definitions
 
-template<random_access Iter>
+template <random_access Iter, typename Pivot, typename Compare>
 void
-quickSort (Iter begin, Iter end, uint cutoff, BS::thread_pool &threads);
+quickSort (Iter begin, Iter end, uint cutoff, BS::thread_pool &threads, uint parallelMin, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Engine engine, Compare less);
+
+template<typename Function>
+void
+forEachStarted (BS::thread_pool &threads, std::size_t count, const Function &f);
+
+template <random_access Iter, typename Pivot, typename Compare>
+void
+pool_select (Iter begin, Iter end, BS::thread_pool &threads, const Input &in, Pivot pick, Compare less);
 
 template<callable Function>
 double 
 timeAlgorithm (const Function &f);
 
-std::vector<uint>
+template<typename Function>
+void
+withPivot (const Input &in, const Function &f);
+
+template<typename T>
+std::vector<T>
 generateTestData(const unsigned size, const unsigned seed);
 
 void
 runReps (Input &in);
 
-template <random_access Iter>
+template<typename T, typename Comp, typename Proj>
+void
+runReps (Input &in, Comp comp, Proj proj);
+
+template <random_access Iter, typename Compare>
 void
-insertionSort (Iter first, Iter last);
+insertionSort (Iter first, Iter last, Compare less);
 
-template<random_access Iter, typename Value>
+template <random_access Iter, typename Compare>
+void
+smallSort (Iter first, Iter last, SmallSort leaf, Compare less);
+
+template<random_access Iter, typename Value, typename Compare>
+std::pair<Iter, Iter>
+partition (Iter begin, Iter end, const Value &pivot, Compare less);
+
+template<random_access Iter, typename Value, typename Compare>
 std::pair<Iter, Iter>
-partition (Iter begin, Iter end, Value pivot);
+partition (Iter begin, Iter end, const Value &pivot, Scheme scheme, Compare less);
+
+template<random_access Iter, typename Compare>
+Segments<Iter>
+partition (Iter begin, Iter end, Scheme scheme, Compare less);
+
+template <random_access Iter, typename Pivot, typename Compare>
+void
+quickSort (Iter begin, Iter end, uint cutoff, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Compare less);
+
+template <random_access Iter, typename Pivot, typename Compare>
+void
+iterativeQuickSort (Iter begin, Iter end, uint cutoff, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Compare less);
 
-template <random_access Iter>
+template <random_access Iter, typename Pivot, typename Compare>
 void
-quickSort (Iter begin, Iter end, uint cutoff);
+serialQuickSort (Iter begin, Iter end, uint cutoff, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Engine engine, Compare less);
 /************************************************************/
 
 int
@@ -76,21 +129,132 @@ main (int argc, char* argv[])
     Due to the changing nature of this method, if documentation is needed 
     it can be found in the file "QuickSort.cpp".
 */
-template<random_access Iter>
+template <random_access Iter, typename Pivot, typename Compare>
 void
-quickSort (Iter begin, Iter end, uint cutoff, BS::thread_pool &threads)
+quickSort (Iter begin, Iter end, uint cutoff, BS::thread_pool &threads, uint parallelMin, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Engine engine, Compare less)
 {
     if(std::distance(begin, end) <= cutoff)
     {
-        insertionSort(begin, end);
+        smallSort(begin, end, leaf, less);
         return;
     }
+    if(budget == 0)
+    {
+        heapsortFallback(begin, end, less);
+        return;
+    }
+
+    if(scheme == Scheme::DualPivot || scheme == Scheme::ThreePivot)
+    {
+        auto parts = partition(begin, end, scheme, less);
+        for(int i = 0; i < parts.count; ++i)
+        {
+            auto [first, last] = parts.ranges[i];
+            if(i + 1 < parts.count)
+            {
+                threads.push_task([=, &threads] {quickSort(first, last, cutoff, threads, parallelMin, scheme, pick, budget - 1, leaf, engine, less);});
+            }
+            else {
+                serialQuickSort(first, last, cutoff, scheme, pick, budget - 1, leaf, engine, less);
+            }
+        }
+        return;
+    }
+
+    auto pivot = pick(begin, end, less);
+    //a range this big would keep the other threads waiting on one core
+    auto [lowPivot, hiPivot] = parallelMin > 0 && std::distance(begin, end) > parallelMin
+        ? parallelPartition(begin, end, pivot, less, threads.get_thread_count(), [&threads] (std::size_t count, const auto &f) {
+            forEachStarted(threads, count, f);
+        })
+        : partition(begin, end, pivot, scheme, less);
+
+    threads.push_task([=, &threads] {quickSort(begin, lowPivot, cutoff, threads, parallelMin, scheme, pick, budget - 1, leaf, engine, less);});
+    serialQuickSort(hiPivot, end, cutoff, scheme, pick, budget - 1, leaf, engine, less);
+}
+
+/** Calls f(0) on the calling thread and pushes f(1) to f(count - 1) to the
+    pool. Once f(0) returns, the tasks that have not started yet are skipped
+    instead of waited for: this may itself be running on a worker, and if
+    every worker waited here, nothing would be left to run them.
+
+    @param threads - the pool to run on
+    @param count - the number of calls
+    @param f - the function to call, which must cope with skipped calls
+*/
+template<typename Function>
+void
+forEachStarted (BS::thread_pool &threads, std::size_t count, const Function &f)
+{
+    //0 while queued, 1 while running, 2 once finished and 3 if skipped
+    std::vector<std::shared_ptr<std::atomic<int>>> states;
+    for(std::size_t i = 1; i < count; ++i)
+    {
+        auto state = std::make_shared<std::atomic<int>>(0);
+        states.push_back(state);
+        threads.push_task([state, &f, i] {
+            int queued = 0;
+            if(!state->compare_exchange_strong(queued, 1)) { return; }
+            f(i);
+            state->store(2);
+            state->notify_one();
+        });
+    }
+    f(0);
 
-    auto pivot = *begin;
-    auto [lowPivot, hiPivot] = partition(begin, end, pivot);
+    for(auto &state : states)
+    {
+        int queued = 0;
+        if(state->compare_exchange_strong(queued, 3)) { continue; }
+        state->wait(1);
+    }
+}
 
-    threads.push_task([=, &threads] {quickSort(begin, lowPivot, cutoff, threads);});
-    quickSort(hiPivot, end, cutoff);
+/** Runs the selection chosen by the user on [begin, end), on the
+    pool. Ranges larger than parallelMin are partitioned by every thread,
+    and the quantiles follow both sides of each partition as tasks.
+
+    @param begin - the start of the range
+    @param end - the end (exclusive) of the range
+    @param threads - the pool to run on
+    @param in - the user input holding the selection, its count and the
+        settings of the sort
+    @param pick - the pivot policy, called on each range to choose its pivot
+    @param less - the ordering to select by
+*/
+template <random_access Iter, typename Pivot, typename Compare>
+void
+pool_select (Iter begin, Iter end, BS::thread_pool &threads, const Input &in, Pivot pick, Compare less)
+{
+    auto split = [&] (Iter first, Iter last) {
+        auto pivot = pick(first, last, less);
+        return in.parallelMin > 0 && std::distance(first, last) > in.parallelMin
+            ? parallelPartition(first, last, pivot, less, threads.get_thread_count(), [&threads] (std::size_t count, const auto &f) {
+                forEachStarted(threads, count, f);
+            })
+            : partition(first, last, pivot, in.scheme, less);
+    };
+
+    std::size_t size = std::distance(begin, end);
+    if(in.selection == Selection::Nth)
+    {
+        quickSelect(begin, begin + size / 2, end, in.cutoff, depthBudget(size), less, split);
+    }
+    else if(in.selection == Selection::TopK)
+    {
+        partialSort(begin, begin + std::min<std::size_t>(in.selectCount, size), end, in.cutoff, depthBudget(size), less, split, [&] (Iter first, Iter last) {
+            quickSort(first, last, in.cutoff, threads, in.parallelMin, in.scheme, pick, depthBudget(std::distance(first, last)), in.smallSort, in.engine, less);
+            threads.wait_for_tasks();
+            if(in.smallSort == SmallSort::Deferred) { finishingPass(first, last, in.cutoff, less); }
+        });
+    }
+    else if(in.selection == Selection::Quantiles)
+    {
+        std::vector<std::size_t> ranks = quantileRanks(size, in.selectCount);
+        auto spawn = [&threads] (auto task) { threads.push_task(task); };
+        multiSelect(begin, end, ranks.data(), ranks.data() + ranks.size(), 0, in.cutoff, depthBudget(size), less, split, spawn);
+        threads.wait_for_tasks();
+    }
 }
 
 /** Times the algorithm passed in as a parameter
@@ -108,7 +272,27 @@ timeAlgorithm (const Function &f)
     return t.getElapsedMs();
 }
 
-/** Generates a vector of random uints in the range [0,UNSIGNED_MAX)
+/** Calls f with the pivot policy selected by the user.
+
+    @param in - the user input holding the pivot policy and sample size
+    @param f - the function to call with the policy object
+*/
+template<typename Function>
+void
+withPivot (const Input &in, const Function &f)
+{
+    switch(in.pivot)
+    {
+        case PivotRule::MedianOf3: f(MedianOf3Pivot{}); break;
+        case PivotRule::Ninther: f(NintherPivot{}); break;
+        case PivotRule::Random: f(RandomPivot{}); break;
+        case PivotRule::Sample: f(SampleMedianPivot{in.sampleSize}); break;
+        default: f(FirstPivot{}); break;
+    }
+}
+
+/** Generates a vector of random elements of type T. uints are drawn from
+    the original 32-bit generator, everything else from randomElement.
 
     @param size - the size of the vector to be generated
     
@@ -117,15 +301,47 @@ timeAlgorithm (const Function &f)
     NOTE: The random numbers generated by this method will be in the same order between
     executions.
 */
-std::vector<uint>
+template<typename T>
+std::vector<T>
 generateTestData(const unsigned size, const unsigned seed)
 {
-    std::vector<uint> ret(size);
-    static std::mt19937 gen{seed};
-    std::ranges::generate(ret, [&] { return gen();});
+    std::vector<T> ret(size);
+    if constexpr (std::is_same_v<T, uint>)
+    {
+        static std::mt19937 gen{seed};
+        std::ranges::generate(ret, [&] { return gen();});
+    }
+    else {
+        static std::mt19937_64 gen{seed};
+        std::ranges::generate(ret, [&] { return randomElement<T>(gen);});
+    }
     return ret;
 }
 
+/** Runs trials on the element type selected by the user. Records are
+    ordered by their key.
+
+    @param in - the user input to be used for all trials.
+*/
+void
+runReps (Input &in)
+{
+    switch(in.element)
+    {
+        case ElementType::U64: runReps<std::uint64_t>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::F64: runReps<double>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::I32: runReps<std::int32_t>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::I64: runReps<std::int64_t>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::F32: runReps<float>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::String16: runReps<String16>(in, std::ranges::less{}, std::identity{}); break;
+        case ElementType::Record: runReps<Record>(in, std::ranges::less{}, &Record::key); break;
+        case ElementType::Record32: runReps<Record32>(in, std::ranges::less{}, &Record32::key); break;
+        case ElementType::Record64: runReps<Record64>(in, std::ranges::less{}, &Record64::key); break;
+        case ElementType::Record256: runReps<Record256>(in, std::ranges::less{}, &Record256::key); break;
+        default: runReps<uint>(in, std::ranges::less{}, std::identity{}); break;
+    }
+}
+
 /** Runs trials according to user specified traits
 
     @param in - the user input to be used for all trials.
@@ -138,25 +354,119 @@ generateTestData(const unsigned size, const unsigned seed)
 
     NOTE: for the sake of readability, if no CSV is generated, only 
     the data from the first 5 reps will be printed.
+
+    NOTE: with a selection chosen, it is first run on a copy of the data
+    and written as its own row, named after the sort and the selection.
+
+    NOTE: with nk set, signed and floating-point keys are sorted as their
+    normalized unsigned keys, and the row is named "Thread Pool Normalized".
+    The two passes over the keys are timed along with the sort.
+
+    NOTE: with lc set, the sampling pre-pass is timed along with the sort,
+    and also written as its own row, "Thread Pool Estimate". The scheme column
+    of both rows is "counting" when the pre-pass chose the counting sort.
+
+    @param comp - the comparator to sort with
+    @param proj - the projection applied to each element before comparing
 */
+template<typename T, typename Comp, typename Proj>
 void
-runReps (Input &in)
+runReps (Input &in, Comp comp, Proj proj)
 {
     std::ofstream file(in.filename, std::ios::app);
+    ProjectedLess<Comp, Proj> less{comp, proj};
 
     for(uint i = 0; i < in.reps; ++i)
     {
-        std::vector<unsigned> data(in.vecSize);
-        data = generateTestData (in.vecSize, in.seed);
+        std::vector<T> data(in.vecSize);
+        data = generateTestData<T> (in.vecSize, in.seed);
+        limitDistinct(data.begin(), data.end(), in.distinct);
+        arrangeRuns(data.begin(), data.end(), in.runs, less);
 
-        double time = timeAlgorithm([&] {
-            BS::thread_pool threads; 
-            quickSort(data.begin(), data.end(), in.cutoff, threads);
-            threads.wait_for_tasks();
+        if(in.selection != Selection::None)
+        {
+            std::vector<T> copy = data;
+            heapsortFallbacks = 0;
+            maxStackDepth = 0;
+            double selectTime = 0;
+            withPivot(in, [&] (auto pick) {
+                selectTime = timeAlgorithm([&] {
+                    BS::thread_pool threads(in.threads);
+                    pool_select(copy.begin(), copy.end(), threads, in, pick, less);
+                });
+            });
+
+            std::string output = std::format("{},{},{},{},{},{},{},{},{},{},{}\n", std::format("Thread Pool {}", selectionNames[static_cast<int>(in.selection)]), selectTime, in.vecSize, schemeNames[static_cast<int>(in.scheme)], pivotNames[static_cast<int>(in.pivot)], heapsortFallbacks.load(), smallSortNames[static_cast<int>(in.smallSort)], elementNames[static_cast<int>(in.element)], 0, maxStackDepth.load(), in.runs);
+            file.write(output.c_str(), output.length());
+        }
+
+        bool normalized = needsNormalizing<T> && in.normalize;
+        bool counted = false;
+        double estimateMs = 0;
+        std::size_t countingBytes = 0;
+        heapsortFallbacks = 0;
+        maxStackDepth = 0;
+        double time = 0;
+        withPivot(in, [&] (auto pick) {
+            time = timeAlgorithm([&] {
+                BS::thread_pool threads(in.threads);
+                auto forEach = [&threads] (std::size_t count, const auto &f) {
+                    for(std::size_t i = 0; i < count; ++i) { threads.push_task([&f, i] {f(i);}); }
+                    threads.wait_for_tasks();
+                };
+                std::size_t threadCount = threads.get_thread_count();
+                auto sortRange = [&] (auto first, auto last, auto less) {
+                    quickSort(first, last, in.cutoff, threads, in.parallelMin, in.scheme, pick, depthBudget(data.size()), in.smallSort, in.engine, less);
+                    threads.wait_for_tasks();
+                    if(in.smallSort == SmallSort::Deferred) { finishingPass(first, last, in.cutoff, less, threadCount, forEach); }
+                };
+                //with lc set, ranges found to hold few distinct keys are
+                //counting sorted instead
+                auto sortKeys = [&] (auto first, auto last, auto less) {
+                    if(in.cardinality)
+                    {
+                        Timer<> pass;
+                        auto estimate = estimateCardinality(first, last, less);
+                        pass.stop();
+                        estimateMs = pass.getElapsedMs();
+                        if(estimate.distinct <= CARDINALITY_LOW_MAX)
+                        {
+                            countingSortByKeys(first, last, estimate.keys, less, threadCount, [&] (auto begin, auto end) {
+                                sortRange(begin, end, less);
+                            }, forEach);
+                            counted = true;
+                            countingBytes = countingSortExtraBytes<std::iter_value_t<decltype(first)>>(std::distance(first, last), estimate.keys.size(), threadCount);
+                            return;
+                        }
+                    }
+                    sortRange(first, last, less);
+                };
+
+                if constexpr (needsNormalizing<T>)
+                {
+                    if(normalized)
+                    {
+                        sortNormalized(data.begin(), data.end(), [&] (auto first, auto last) {
+                            sortKeys(first, last, DefaultLess{});
+                        }, forEach);
+                        return;
+                    }
+                }
+                sortKeys(data.begin(), data.end(), less);
+            });
         });
 
-        std::string output = std::format("{},{},{}\n", "Thread Pool", time, in.vecSize);
+        std::size_t extraBytes = 0;
+        if constexpr (needsNormalizing<T>) { extraBytes = normalized ? data.size() * sizeof(NormalizedKeyType<T>) : 0; }
+        extraBytes += countingBytes;
+        std::string output = std::format("{},{},{},{},{},{},{},{},{},{},{}\n", normalized ? "Thread Pool Normalized" : "Thread Pool", time, in.vecSize, counted ? "counting" : schemeNames[static_cast<int>(in.scheme)], pivotNames[static_cast<int>(in.pivot)], heapsortFallbacks.load(), smallSortNames[static_cast<int>(in.smallSort)], elementNames[static_cast<int>(in.element)], extraBytes, maxStackDepth.load(), in.runs);
         file.write(output.c_str(), output.length());
+
+        if(in.cardinality)
+        {
+            output = std::format("{},{},{},{},{},{},{},{},{},{},{}\n", "Thread Pool Estimate", estimateMs, in.vecSize, counted ? "counting" : schemeNames[static_cast<int>(in.scheme)], pivotNames[static_cast<int>(in.pivot)], 0, smallSortNames[static_cast<int>(in.smallSort)], elementNames[static_cast<int>(in.element)], CARDINALITY_SAMPLE * sizeof(T), 0, in.runs);
+            file.write(output.c_str(), output.length());
+        }
     }
 }
 
@@ -167,30 +477,48 @@ runReps (Input &in)
     @param numTrials - the number of times to repeat the above process
     @param in - the user input to use as the basis for these trials
 */
-template <random_access Iter>
+template <random_access Iter, typename Compare>
 void
-insertionSort (Iter first, Iter last)
+insertionSort (Iter first, Iter last, Compare less)
 {
     if(std::distance(first, last) < 2) { return; }
 
     Iter prev;
-    unsigned key; 
     for(Iter cur = std::next(first); cur != last; ++cur)
     {
-        //store the current value out
-        key = *cur;
+        //move the current value out
+        auto key = std::move(*cur);
         prev = std::prev(cur);
-        while (std::distance (first, prev) >= 0 && *prev > key)
+        while (std::distance (first, prev) >= 0 && less(key, *prev))
         {
-            //copy the value of prev up one
-            *(std::next(prev)) = *prev;
+            //move the value of prev up one
+            *(std::next(prev)) = std::move(*prev);
             //decrement prev
            --prev;
         }
-        *(std::next(prev)) = key;
+        *(std::next(prev)) = std::move(key);
     }
 }
 
+/** Sorts a range below the cutoff with the sort selected by leaf. Ranges
+    the sorting network cannot handle use insertion sort, and deferred
+    ranges are left as they are.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param leaf - the small sort to use
+    @param less - the ordering to sort by
+*/
+template <random_access Iter, typename Compare>
+void
+smallSort (Iter first, Iter last, SmallSort leaf, Compare less)
+{
+    //deferred ranges are sorted by finishingPass once the quicksort is done
+    if(leaf == SmallSort::Deferred) { return; }
+    if(leaf == SmallSort::Network && networkSort(first, last, less)) { return; }
+    insertionSort(first, last, less);
+}
+
 /** Partitions the range [begin, end) such that all elements less than *pivot 
     come before pivot, all elements equal to *pivot are in the middle, and all
     elements greater than *pivot are after towards the end.
@@ -201,15 +529,16 @@ insertionSort (Iter first, Iter last)
     @param end - one past the end of the range to partition
     @param pivot - an iterator pointing to the value on which the range should 
         be partitioned
+    @param less - the ordering to partition by
     
     @return - a pair such that all elements to the left of pair.first
             are less than pivot, all elements between pair.first and 
             pair.second are equal to pivot, and all elements after
             pair.second are greater than the pivot.
 */
-template<random_access Iter, typename Value>
+template<random_access Iter, typename Value, typename Compare>
 std::pair<Iter, Iter>
-partition (Iter begin, Iter end, Value pivot)
+partition (Iter begin, Iter end, const Value &pivot, Compare less)
 {
     if(std::distance(begin, end) <= 1) { return {begin, end}; }
   
@@ -219,13 +548,13 @@ partition (Iter begin, Iter end, Value pivot)
 
     while (cur < nextHigh)
     {
-        if(*cur < pivot)
+        if(less(*cur, pivot))
         {
             std::iter_swap(cur, nextLow);
             ++nextLow;
             ++cur;
         }
-        else if(*cur > pivot)
+        else if(less(pivot, *cur))
         {
             --nextHigh;
             std::iter_swap(cur, nextHigh);
@@ -236,28 +565,144 @@ partition (Iter begin, Iter end, Value pivot)
     return {nextLow, nextHigh};
 }
 
-/** Performs a dual-pivot serial quicksort on the range [begin, end),
-    switching to insertion sort on smaller sample sizes.
+/** Partitions the range [begin, end) around pivot using the kernel selected
+    by scheme. See partition, blockPartition, simdPartition and
+    stablePartition for the exact contracts. The adaptive scheme uses
+    blockPartition unless pivotRepeats finds copies of the pivot.
+
+    @param begin - the start of the range to partition
+    @param end - one past the end of the range to partition
+    @param pivot - the value on which the range should be partitioned
+    @param scheme - the partitioning kernel to use
+    @param less - the ordering to partition by
+
+    @return - a pair such that all elements to the left of pair.first
+            are less than pivot, all elements between pair.first and
+            pair.second are equal to pivot, and all elements after
+            pair.second are not less than the pivot.
+*/
+template<random_access Iter, typename Value, typename Compare>
+std::pair<Iter, Iter>
+partition (Iter begin, Iter end, const Value &pivot, Scheme scheme, Compare less)
+{
+    if(scheme == Scheme::Block) { return blockPartition(begin, end, pivot, less); }
+    if(scheme == Scheme::Simd) { return simdPartition(begin, end, pivot, less); }
+    if(scheme == Scheme::Stable) { return stablePartition(begin, end, pivot, less); }
+    if(scheme == Scheme::Adaptive && !pivotRepeats(begin, end, pivot, less)) { return blockPartition(begin, end, pivot, less); }
+    return partition(begin, end, pivot, less);
+}
+
+/** Partitions the range [begin, end) with the multi-pivot kernel selected
+    by scheme. See dualPivotPartition and threePivotPartition.
+
+    @param begin - the start of the range to partition
+    @param end - one past the end of the range to partition
+    @param scheme - the partitioning kernel to use, DualPivot or ThreePivot
+    @param less - the ordering to partition by
+
+    @return - the ranges that are left to sort
+*/
+template<random_access Iter, typename Compare>
+Segments<Iter>
+partition (Iter begin, Iter end, Scheme scheme, Compare less)
+{
+    if(scheme == Scheme::ThreePivot) { return threePivotPartition(begin, end, less); }
+    return dualPivotPartition(begin, end, less);
+}
+
+/** Performs a 3-way (or, if scheme asks for it, multi-pivot) serial
+    quicksort on the range [begin, end), switching to insertion sort on
+    smaller sample sizes.
 
     @param begin - the start of the range to be sorted
     @param end - the end (exclusive) of the range to be sorted
     @param cutoff - the point at which insertion sort should be used instead
+    @param scheme - the partitioning kernel to use
+    @param pick - the pivot policy, called on each range to choose its pivot
+    @param budget - the number of partitioning levels left before the range
+        is heapsorted instead
+    @param leaf - the sort to use on ranges below the cutoff
+    @param less - the ordering to sort by
     @param useOMP - if this is 1, OMP tasks will be used to parallelize the sort
         the default value of this parameter is 0.
 */
-template <random_access Iter>
+template <random_access Iter, typename Pivot, typename Compare>
 void
-quickSort (Iter begin, Iter end, uint cutoff)
+quickSort (Iter begin, Iter end, uint cutoff, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Compare less)
 {
     if(std::distance(begin, end) <= cutoff)
     {
-        insertionSort(begin, end);
+        smallSort(begin, end, leaf, less);
+        return;
+    }
+    if(budget == 0)
+    {
+        heapsortFallback(begin, end, less);
+        return;
+    }
+    if(scheme == Scheme::DualPivot || scheme == Scheme::ThreePivot)
+    {
+        for(const auto &part : partition(begin, end, scheme, less))
+        {
+            quickSort(part.first, part.second, cutoff, scheme, pick, budget - 1, leaf, less);
+        }
         return;
     }
-    auto pivot = *begin;
-    auto [lowPivot, hiPivot] = partition(begin, end, pivot);
 
-    quickSort(begin, lowPivot, cutoff);
-    quickSort(hiPivot, end, cutoff);
+    auto pivot = pick(begin, end, less);
+    auto [lowPivot, hiPivot] = partition(begin, end, pivot, scheme, less);
+
+    quickSort(begin, lowPivot, cutoff, scheme, pick, budget - 1, leaf, less);
+    quickSort(hiPivot, end, cutoff, scheme, pick, budget - 1, leaf, less);
 }
 
+/** Performs the same sort as quickSort, but keeps the ranges left to sort
+    on the explicit stack of quickSortLoop instead of recursing.
+
+    @param begin - the start of the range to be sorted
+    @param end - the end (exclusive) of the range to be sorted
+    @param cutoff - the point at which the small sort should be used instead
+    @param scheme - the partitioning kernel to use
+    @param pick - the pivot policy, called on each range to choose its pivot
+    @param budget - the number of partitioning levels left before the range
+        is heapsorted instead
+    @param leaf - the sort to use on ranges below the cutoff
+    @param less - the ordering to sort by
+*/
+template <random_access Iter, typename Pivot, typename Compare>
+void
+iterativeQuickSort (Iter begin, Iter end, uint cutoff, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Compare less)
+{
+    quickSortLoop(begin, end, cutoff, budget, less,
+        [=] (Iter first, Iter last) { smallSort(first, last, leaf, less); },
+        [=] (Iter first, Iter last) {
+            if(scheme == Scheme::DualPivot || scheme == Scheme::ThreePivot)
+            {
+                return partition(first, last, scheme, less);
+            }
+            auto pivot = pick(first, last, less);
+            auto [lowPivot, hiPivot] = partition(first, last, pivot, scheme, less);
+            Segments<Iter> parts;
+            parts.add(first, lowPivot);
+            parts.add(hiPivot, last);
+            return parts;
+        });
+}
+
+/** Sorts [begin, end) on the calling thread with the engine selected by the
+    user. The parallel sort hands its leaf ranges to this.
+
+    @param engine - recursive for quickSort, iterative for iterativeQuickSort
+*/
+template <random_access Iter, typename Pivot, typename Compare>
+void
+serialQuickSort (Iter begin, Iter end, uint cutoff, Scheme scheme, Pivot pick, uint budget, SmallSort leaf, Engine engine, Compare less)
+{
+    if(engine == Engine::Iterative)
+    {
+        iterativeQuickSort(begin, end, cutoff, scheme, pick, budget, leaf, less);
+    }
+    else {
+        quickSort(begin, end, cutoff, scheme, pick, budget, leaf, less);
+    }
+}
@@ -0,0 +1,219 @@
+/*
+  Filename   : Argsort.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: An indirect sort for elements too wide to move on every
+               swap. Only (key, index) pairs are sorted, which gives the
+               permutation that sorts the elements, and the permutation is
+               then applied to one or more arrays in a single pass each.
+               It can be applied out of place, gathering each block of the
+               output from the input, or in place, rotating each cycle of
+               the permutation from its smallest index.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef ARGSORT_H
+#define ARGSORT_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/************************************************************/
+// Local includes
+
+/************************************************************/
+// Using declarations
+
+//the number of elements of each array one task permutes at a time. A
+//block of indices is reused for every array, so it should stay in cache.
+const static std::size_t PERMUTE_BLOCK = 4096;
+
+//how many elements ahead the gather prefetches its sources
+const static std::size_t PERMUTE_PREFETCH = 16;
+
+/** A sort key and the position of the element it came from.
+
+    @param Key - the type of the key
+    @param Index - the type of the position
+*/
+template<typename Key, typename Index = std::uint32_t>
+struct KeyIndex
+{
+    Key key{};
+    Index index{};
+};
+
+/************************************************************/
+
+/** Computes the heap memory an argsort and applyPermutation use besides
+    the range.
+
+    @param size - the number of elements to be sorted
+    @param inPlace - true if the permutation is applied in place
+
+    @return - the size of the pairs, the permutation and either the gather
+        buffer or the cycle flags, in bytes
+*/
+template<typename T, typename Key, typename Index = std::uint32_t>
+std::size_t
+argsortExtraBytes (std::size_t size, bool inPlace)
+{
+    std::size_t apply = inPlace ? size * sizeof(std::atomic<bool>) : size * sizeof(T);
+    return size * (sizeof(KeyIndex<Key, Index>) + sizeof(Index)) + apply;
+}
+
+/** Finds the permutation that sorts [first, last) by key.
+
+    @param first - the start of the range
+    @param last - the end (exclusive) of the range
+    @param proj - the projection giving each element's key
+    @param sortPairs - called as sortPairs(begin, end) to sort the
+        KeyIndex pairs by key
+    @param forEach - called as forEach(count, f), it must call f(i) for
+        every i in [0, count) in parallel and return once all have finished
+
+    @return - perm, such that perm[i] is the position of the i-th smallest
+        element
+*/
+template<typename Index = std::uint32_t, std::random_access_iterator Iter, typename Proj, typename SortPairs,
+    typename ForEach>
+std::vector<Index>
+argsort (Iter first, Iter last, Proj proj, const SortPairs &sortPairs, const ForEach &forEach)
+{
+    using Key = std::remove_cvref_t<std::invoke_result_t<Proj&, std::iter_reference_t<Iter>>>;
+
+    std::size_t size = std::distance(first, last);
+    std::size_t blocks = (size + PERMUTE_BLOCK - 1) / PERMUTE_BLOCK;
+    std::vector<KeyIndex<Key, Index>> pairs(size);
+    forEach(blocks, [&] (std::size_t b) {
+        for(std::size_t i = b * PERMUTE_BLOCK; i < std::min(size, (b + 1) * PERMUTE_BLOCK); ++i)
+        {
+            pairs[i] = {std::invoke(proj, first[i]), static_cast<Index>(i)};
+        }
+    });
+
+    sortPairs(pairs.begin(), pairs.end());
+
+    std::vector<Index> perm(size);
+    forEach(blocks, [&] (std::size_t b) {
+        for(std::size_t i = b * PERMUTE_BLOCK; i < std::min(size, (b + 1) * PERMUTE_BLOCK); ++i)
+        {
+            perm[i] = pairs[i].index;
+        }
+    });
+    return perm;
+}
+
+/** Reorders arrays by a permutation, through a buffer per array. Each
+    task gathers one block of every array's output, so the block's indices
+    are read from memory once, and then the buffers are moved back.
+
+    @param perm - the permutation, where perm[i] is the position the i-th
+        element is taken from
+    @param forEach - called as forEach(count, f), it must call f(i) for
+        every i in [0, count) in parallel and return once all have finished
+    @param arrays - the start of each array to reorder, each holding at
+        least perm.size() elements
+*/
+template<typename Index, typename ForEach, std::random_access_iterator... Iters>
+void
+applyPermutation (const std::vector<Index> &perm, const ForEach &forEach, Iters... arrays)
+{
+    std::size_t size = perm.size();
+    std::size_t blocks = (size + PERMUTE_BLOCK - 1) / PERMUTE_BLOCK;
+    std::tuple<std::vector<std::iter_value_t<Iters>>...> buffers{std::vector<std::iter_value_t<Iters>>(size)...};
+
+    forEach(blocks, [&] (std::size_t b) {
+        std::size_t begin = b * PERMUTE_BLOCK;
+        std::size_t end = std::min(size, begin + PERMUTE_BLOCK);
+        auto gather = [&] (auto array, auto &buffer) {
+            for(std::size_t i = begin; i < end; ++i)
+            {
+                if(i + PERMUTE_PREFETCH < end) { __builtin_prefetch(std::addressof(array[perm[i + PERMUTE_PREFETCH]])); }
+                buffer[i] = std::move(array[perm[i]]);
+            }
+        };
+        std::apply([&] (auto &...buffer) { (gather(arrays, buffer), ...); }, buffers);
+    });
+
+    forEach(blocks, [&] (std::size_t b) {
+        std::size_t begin = b * PERMUTE_BLOCK;
+        std::size_t end = std::min(size, begin + PERMUTE_BLOCK);
+        std::apply([&] (auto &...buffer) {
+            (std::move(buffer.begin() + begin, buffer.begin() + end, arrays + begin), ...);
+        }, buffers);
+    });
+}
+
+/** Reorders arrays by a permutation in place. Every cycle of the
+    permutation is rotated by the task that holds its smallest index, its
+    leader, so the cycles are shared out without locking. Each task checks
+    whether its indices lead their cycles by walking them until a smaller
+    index turns up, which is O(n log n) steps in all for a random
+    permutation.
+
+    NOTE: a permutation with one long cycle that rises from its leader,
+    such as a rotation, takes O(n^2) steps to check
+
+    @param perm - the permutation, where perm[i] is the position the i-th
+        element is taken from
+    @param forEach - called as forEach(count, f), it must call f(i) for
+        every i in [0, count) in parallel and return once all have finished
+    @param arrays - the start of each array to reorder, each holding at
+        least perm.size() elements
+*/
+template<typename Index, typename ForEach, std::random_access_iterator... Iters>
+void
+applyPermutationInPlace (const std::vector<Index> &perm, const ForEach &forEach, Iters... arrays)
+{
+    std::size_t size = perm.size();
+    std::size_t blocks = (size + PERMUTE_BLOCK - 1) / PERMUTE_BLOCK;
+    //set once a cycle has been rotated, so later checks of it stop early.
+    //The flags start out false, as atomics are value-initialized.
+    std::unique_ptr<std::atomic<bool>[]> done(new std::atomic<bool>[size]);
+
+    forEach(blocks, [&] (std::size_t b) {
+        for(std::size_t i = b * PERMUTE_BLOCK; i < std::min(size, (b + 1) * PERMUTE_BLOCK); ++i)
+        {
+            if(perm[i] == i || done[i].load(std::memory_order_relaxed)) { continue; }
+            bool leader = true;
+            for(std::size_t j = perm[i]; j != i && leader; j = perm[j])
+            {
+                leader = j > i && !done[j].load(std::memory_order_relaxed);
+            }
+            if(!leader) { continue; }
+
+            auto rotate = [&] (auto array) {
+                auto first = std::move(array[i]);
+                std::size_t j = i;
+                for(; perm[j] != i; j = perm[j]) { array[j] = std::move(array[perm[j]]); }
+                array[j] = std::move(first);
+            };
+            (rotate(arrays), ...);
+            for(std::size_t j = i; !done[j].load(std::memory_order_relaxed); j = perm[j])
+            {
+                done[j].store(true, std::memory_order_relaxed);
+            }
+        }
+    });
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
@@ -0,0 +1,321 @@
+/*
+  Filename   : BlockDistribution.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: An in-place, parallel distribution of a range into buckets,
+               after the block permutation of IPS4o (Axtmann et al.). Each
+               thread classifies its own stripe into small per-bucket
+               buffers and writes full buffers back into the stripe as
+               blocks. The blocks are then permuted into their buckets by
+               all threads at once, and the few elements left in the
+               buffers fill the gaps at the bucket boundaries. Besides the
+               buffers, which do not depend on the size of the range, no
+               extra memory is used.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef BLOCK_DISTRIBUTION_H
+#define BLOCK_DISTRIBUTION_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/************************************************************/
+// Local includes
+
+/************************************************************/
+// Using declarations
+
+//the size of a block in bytes. Big enough to amortize the bookkeeping,
+//small enough that a buffer for every bucket fits in L2.
+const static std::size_t DISTRIBUTION_BLOCK_BYTES = 2048;
+
+/** The number of elements of type T in a block. */
+template<typename T>
+constexpr std::size_t distributionBlockSize = std::max<std::size_t>(1, DISTRIBUTION_BLOCK_BYTES / sizeof(T));
+
+/** The state of one thread during the local classification. */
+template<typename T>
+struct LocalBuckets
+{
+    //a buffer of one block per bucket
+    std::vector<T> buffer;
+    //the number of elements in each bucket's buffer
+    std::vector<std::size_t> fill;
+    //the number of elements classified into each bucket
+    std::vector<std::size_t> count;
+    //the number of full blocks written back to the start of the stripe
+    std::size_t flushed{0};
+};
+
+/************************************************************/
+
+/** Computes the heap memory blockDistribute uses besides the range.
+
+    @param threads - the number of threads distributing
+    @param numBuckets - the number of buckets
+
+    @return - the size of the buffers, in bytes
+*/
+template<typename T>
+std::size_t
+distributionExtraBytes (std::size_t threads, std::size_t numBuckets)
+{
+    //one buffer per thread, plus the spilled elements and the overflow block
+    return ((threads + 1) * numBuckets + 1) * distributionBlockSize<T> * sizeof(T);
+}
+
+/** Reorders [first, last) such that elements are grouped by bucket, in
+    increasing order of bucket. Elements keep no particular order within a
+    bucket.
+
+    @param first - the start of the range to distribute
+    @param last - one past the end of the range to distribute
+    @param numBuckets - the number of buckets
+    @param classify - returns the bucket, in [0, numBuckets), of an element
+    @param threads - the number of stripes, each classified by one thread
+    @param forEach - called as forEach(count, f), it must call f(i) for
+        every i in [0, count) in parallel and return once all have finished
+
+    @return - the bucket boundaries: bucket b holds [first + ret[b],
+        first + ret[b + 1])
+*/
+template<std::random_access_iterator Iter, typename Classify, typename ForEach>
+std::vector<std::size_t>
+blockDistribute (Iter first, Iter last, std::size_t numBuckets, Classify classify, std::size_t threads,
+    const ForEach &forEach)
+{
+    using T = std::iter_value_t<Iter>;
+    const std::size_t B = distributionBlockSize<T>;
+
+    std::size_t size = std::distance(first, last);
+    std::size_t numBlocks = size / B;
+    threads = std::max<std::size_t>(1, std::min(threads, numBlocks));
+
+    //stripes are made of whole blocks, except the last one which also takes
+    //the partial block at the end
+    std::vector<std::size_t> stripes(threads + 1);
+    for(std::size_t i = 0; i < threads; ++i)
+    {
+        stripes[i] = i * numBlocks / threads * B;
+    }
+    stripes[threads] = size;
+
+    //classify each stripe into its buffers, writing full buffers back to
+    //the start of the stripe. The write position can never pass the read
+    //position, as everything written has already been read.
+    std::vector<LocalBuckets<T>> local(threads);
+    forEach(threads, [&] (std::size_t i) {
+        LocalBuckets<T> &mine = local[i];
+        mine.buffer.resize(numBuckets * B);
+        mine.fill.assign(numBuckets, 0);
+        mine.count.assign(numBuckets, 0);
+
+        Iter write = first + stripes[i];
+        for(Iter cur = first + stripes[i]; cur != first + stripes[i + 1]; ++cur)
+        {
+            std::size_t b = classify(*cur);
+            T* buf = mine.buffer.data() + b * B;
+            if(mine.fill[b] == B)
+            {
+                write = std::move(buf, buf + B, write);
+                ++mine.flushed;
+                mine.fill[b] = 0;
+            }
+            buf[mine.fill[b]++] = std::move(*cur);
+            ++mine.count[b];
+        }
+    });
+
+    std::vector<std::size_t> bounds(numBuckets + 1, 0);
+    for(std::size_t b = 0; b < numBuckets; ++b)
+    {
+        bounds[b + 1] = bounds[b];
+        for(const auto &mine : local) { bounds[b + 1] += mine.count[b]; }
+    }
+
+    //bucket b permutes its blocks within [regions[b], regions[b + 1]), in
+    //block units, which are its bounds rounded up to whole blocks
+    std::vector<std::size_t> regions(numBuckets + 1);
+    for(std::size_t b = 0; b <= numBuckets; ++b)
+    {
+        regions[b] = (bounds[b] + B - 1) / B;
+    }
+
+    auto isFull = [&] (std::size_t block) {
+        std::size_t i = std::upper_bound(stripes.begin(), stripes.end() - 1, block * B) - stripes.begin() - 1;
+        return block < stripes[i] / B + local[i].flushed;
+    };
+    auto blockAt = [&] (std::size_t block) { return first + block * B; };
+
+    //move the full blocks of each region to its front. A region only has
+    //gaps where it crosses into another stripe, so few blocks move.
+    std::vector<std::size_t> writes(numBuckets);
+    std::vector<std::size_t> reads(numBuckets);
+    forEach(threads, [&] (std::size_t i) {
+        for(std::size_t b = i; b < numBuckets; b += threads)
+        {
+            std::size_t start = regions[b];
+            std::size_t stop = std::min(regions[b + 1], numBlocks);
+            std::size_t full = 0;
+            for(std::size_t block = start; block < stop; ++block) { full += isFull(block); }
+
+            std::size_t empty = start;
+            for(std::size_t block = start + full; block < stop; ++block)
+            {
+                if(!isFull(block)) { continue; }
+                while (isFull(empty)) { ++empty; }
+                std::move(blockAt(block), blockAt(block) + B, blockAt(empty));
+                ++empty;
+            }
+            writes[b] = start;
+            reads[b] = start + full;
+        }
+    });
+
+    //permute the blocks. Blocks [writes[b], reads[b]) are full and not yet
+    //looked at, blocks before writes[b] are already in bucket b, and the
+    //rest of the region is empty. A block that would stick out past the
+    //end of the range goes to the overflow buffer instead.
+    std::vector<std::mutex> locks(numBuckets);
+    std::vector<T> overflow(B);
+    bool overflowed = false;
+    forEach(threads, [&] (std::size_t i) {
+        std::vector<T> held(B);
+        for(std::size_t step = 0; step < numBuckets; ++step)
+        {
+            std::size_t b = (i * numBuckets / threads + step) % numBuckets;
+            while (true)
+            {
+                {
+                    std::lock_guard<std::mutex> guard(locks[b]);
+                    if(reads[b] <= writes[b]) { break; }
+                    --reads[b];
+                    std::move(blockAt(reads[b]), blockAt(reads[b]) + B, held.begin());
+                }
+
+                //swap the held block into place until it lands on an empty slot
+                while (true)
+                {
+                    std::size_t dest = classify(held[0]);
+                    std::lock_guard<std::mutex> guard(locks[dest]);
+                    std::size_t slot = writes[dest]++;
+                    if(slot < reads[dest])
+                    {
+                        std::swap_ranges(held.begin(), held.end(), blockAt(slot));
+                        continue;
+                    }
+                    if(slot == numBlocks)
+                    {
+                        std::move(held.begin(), held.end(), overflow.begin());
+                        overflowed = true;
+                    }
+                    else {
+                        std::move(held.begin(), held.end(), blockAt(slot));
+                    }
+                    break;
+                }
+            }
+        }
+    });
+
+    //the part of the overflow block that is inside the range goes back
+    std::size_t tail = size - numBlocks * B;
+    if(overflowed) { std::move(overflow.begin(), overflow.begin() + tail, blockAt(numBlocks)); }
+    auto elementAt = [&] (std::size_t pos) -> T & {
+        return pos < size ? first[pos] : overflow[pos - numBlocks * B];
+    };
+
+    //the blocks of a bucket can stick out past its end into the next
+    //buckets. Save those elements first, as their slots are reused below.
+    std::vector<std::vector<T>> spills(numBuckets);
+    forEach(threads, [&] (std::size_t i) {
+        for(std::size_t b = i; b < numBuckets; b += threads)
+        {
+            std::size_t written = writes[b] * B;
+            for(std::size_t pos = std::max(bounds[b + 1], regions[b] * B); pos < written; ++pos)
+            {
+                spills[b].push_back(std::move(elementAt(pos)));
+            }
+        }
+    });
+
+    //fill the gaps at the start and end of each bucket with its spilled
+    //elements and what is left in the buffers
+    forEach(threads, [&] (std::size_t i) {
+        for(std::size_t b = i; b < numBuckets; b += threads)
+        {
+            std::size_t blocksStart = std::min(regions[b] * B, bounds[b + 1]);
+            std::size_t blocksEnd = std::max(blocksStart, std::min(writes[b] * B, bounds[b + 1]));
+
+            std::size_t pos = bounds[b];
+            auto place = [&] (T &val) {
+                if(pos == blocksStart) { pos = blocksEnd; }
+                first[pos++] = std::move(val);
+            };
+            for(T &val : spills[b]) { place(val); }
+            for(auto &mine : local)
+            {
+                T* buf = mine.buffer.data() + b * B;
+                for(std::size_t j = 0; j < mine.fill[b]; ++j) { place(buf[j]); }
+            }
+        }
+    });
+
+    return bounds;
+}
+
+/** The serial counterpart of blockDistribute, for ranges too small to pay
+    for the buffers. Elements are swapped into their buckets by following
+    cycles, as in the American flag sort, so each one is classified twice
+    but nothing is buffered.
+
+    @param first - the start of the range to distribute
+    @param last - one past the end of the range to distribute
+    @param numBuckets - the number of buckets
+    @param classify - returns the bucket, in [0, numBuckets), of an element
+
+    @return - the bucket boundaries: bucket b holds [first + ret[b],
+        first + ret[b + 1])
+*/
+template<std::random_access_iterator Iter, typename Classify>
+std::vector<std::size_t>
+cycleDistribute (Iter first, Iter last, std::size_t numBuckets, Classify classify)
+{
+    std::vector<std::size_t> bounds(numBuckets + 1, 0);
+    for(Iter cur = first; cur != last; ++cur) { ++bounds[classify(*cur) + 1]; }
+    for(std::size_t b = 0; b < numBuckets; ++b) { bounds[b + 1] += bounds[b]; }
+
+    std::vector<std::size_t> heads(bounds.begin(), bounds.end() - 1);
+    for(std::size_t b = 0; b < numBuckets; ++b)
+    {
+        while (heads[b] < bounds[b + 1])
+        {
+            auto val = std::move(first[heads[b]]);
+            std::size_t dest = classify(val);
+            while (dest != b)
+            {
+                std::swap(val, first[heads[dest]++]);
+                dest = classify(val);
+            }
+            first[heads[b]++] = std::move(val);
+        }
+    }
+    return bounds;
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
@@ -0,0 +1,148 @@
+/*
+  Filename   : BlockPartition.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: A branchless block partition in the style of BlockQuicksort
+               (Edelkamp & Weiss). Comparison results are buffered as offsets
+               into small per-side blocks, and misplaced elements are swapped
+               in bulk afterwards, so the inner loops contain no
+               data-dependent branches.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef BLOCK_PARTITION_H
+#define BLOCK_PARTITION_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+/************************************************************/
+// Local includes
+
+/************************************************************/
+// Using declarations
+
+//the number of elements classified per side before swapping. Must fit in
+//an unsigned char so that the offset buffers stay in L1.
+const static std::size_t BLOCK_SIZE = 128;
+
+/************************************************************/
+
+/** Reorders [begin, end) such that every element for which @p pred holds
+    comes before every element for which it does not.
+
+    NOTE: Unstable partition
+
+    @param begin - the start of the range to partition
+    @param end - one past the end of the range to partition
+    @param pred - the predicate to partition by
+
+    @return - an iterator to the first element for which @p pred is false
+*/
+template<std::random_access_iterator Iter, typename Predicate>
+Iter
+blockPartitionBy (Iter begin, Iter end, Predicate pred)
+{
+    unsigned char offsetsL[BLOCK_SIZE];
+    unsigned char offsetsR[BLOCK_SIZE];
+
+    std::size_t startL = 0, numL = 0;
+    std::size_t startR = 0, numR = 0;
+
+    //everything before left already satisfies pred, everything from
+    //right on already fails it.
+    Iter left = begin;
+    Iter right = end;
+
+    while (std::distance(left, right) > static_cast<std::ptrdiff_t>(2 * BLOCK_SIZE))
+    {
+        //record the offsets of elements that are on the wrong side, the
+        //count advances by the result of the comparison instead of a branch
+        if(numL == 0)
+        {
+            startL = 0;
+            for(std::size_t i = 0; i < BLOCK_SIZE; ++i)
+            {
+                offsetsL[numL] = static_cast<unsigned char>(i);
+                numL += !pred(left[i]);
+            }
+        }
+        if(numR == 0)
+        {
+            startR = 0;
+            for(std::size_t i = 0; i < BLOCK_SIZE; ++i)
+            {
+                offsetsR[numR] = static_cast<unsigned char>(i);
+                numR += pred(*(right - 1 - i));
+            }
+        }
+
+        std::size_t num = std::min(numL, numR);
+        for(std::size_t i = 0; i < num; ++i)
+        {
+            std::iter_swap(left + offsetsL[startL + i], right - 1 - offsetsR[startR + i]);
+        }
+
+        numL -= num;
+        numR -= num;
+        startL += num;
+        startR += num;
+
+        if(numL == 0) { left += BLOCK_SIZE; }
+        if(numR == 0) { right -= BLOCK_SIZE; }
+    }
+
+    //at most two blocks remain, some of which may already be placed
+    while (left < right)
+    {
+        if(pred(*left)) { ++left; }
+        else { std::iter_swap(left, --right); }
+    }
+    return left;
+}
+
+/** Partitions the range [begin, end) around pivot with the same contract
+    as the 3-way partition, using branchless block partitioning.
+
+    Elements equal to the pivot are only gathered into the middle when no
+    element is less than the pivot (e.g. a run of duplicates). Otherwise the
+    equal range is empty and they are left with the greater elements, which
+    saves a second pass over the common case.
+
+    @param begin - the start of the range to partition
+    @param end - one past the end of the range to partition
+    @param pivot - the value on which the range should be partitioned
+    @param less - the ordering to partition by
+
+    @return - a pair such that all elements to the left of pair.first
+            are less than pivot, all elements between pair.first and
+            pair.second are equal to pivot, and all elements after
+            pair.second are not less than the pivot.
+*/
+template<std::random_access_iterator Iter, typename Value, typename Compare>
+std::pair<Iter, Iter>
+blockPartition (Iter begin, Iter end, const Value &pivot, Compare less)
+{
+    if(std::distance(begin, end) <= 1) { return {begin, end}; }
+
+    Iter mid = blockPartitionBy(begin, end, [&] (const auto &val) { return less(val, pivot); });
+    if(mid != begin) { return {mid, mid}; }
+
+    //nothing was less than the pivot, so peel off the elements equal to it
+    Iter high = blockPartitionBy(begin, end, [&] (const auto &val) { return !less(pivot, val); });
+    return {begin, high};
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
@@ -0,0 +1,257 @@
+/*
+  Filename   : Cardinality.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: Sorting by how many distinct keys there are. A pre-pass
+               estimates the number of distinct keys from a sample. When
+               there are few, the range is counting sorted in parallel: each
+               element is looked up among the keys the sample found, counted
+               and scattered into its key's bucket, so a few hundred keys take
+               three passes instead of log-depth partitions. Elements whose
+               key the sample missed go to the gap between the keys around
+               them, which is sorted on its own. When there are many keys,
+               the adaptive partition picks a 2-way block partition for each
+               range, unless a probe of the range finds copies of its pivot,
+               when the 3-way partition is worth its extra work.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef CARDINALITY_H
+#define CARDINALITY_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <vector>
+
+/************************************************************/
+// Local includes
+
+/************************************************************/
+// Using declarations
+
+//the number of elements the pre-pass samples
+const static std::size_t CARDINALITY_SAMPLE = 4096;
+
+//the most distinct keys the counting sort is used for
+const static std::size_t CARDINALITY_LOW_MAX = 1024;
+
+//the number of evenly spaced elements the adaptive partition compares to
+//the pivot
+const static std::size_t ADAPTIVE_PROBE = 16;
+
+/** The result of the sampling pre-pass.
+
+    @param T - the type of the elements
+*/
+template<typename T>
+struct CardinalityEstimate
+{
+    //the estimated number of distinct keys in the whole range
+    double distinct{0};
+    //one element of each key found in the sample, in order
+    std::vector<T> keys;
+};
+
+/************************************************************/
+
+/** Estimates the number of distinct keys in [first, last) from a random
+    sample, with the GEE estimator: the keys seen more than once are
+    counted once, and the keys seen once are scaled up by the square root
+    of the inverse of the sampling rate.
+
+    @param first - the start of the range
+    @param last - the end (exclusive) of the range
+    @param less - the ordering the keys are compared by
+
+    @return - the estimate, and the sample's distinct keys. Ranges no
+        larger than the sample are counted exactly.
+*/
+template<std::random_access_iterator Iter, typename Compare>
+CardinalityEstimate<std::iter_value_t<Iter>>
+estimateCardinality (Iter first, Iter last, Compare less)
+{
+    using T = std::iter_value_t<Iter>;
+
+    std::size_t size = std::distance(first, last);
+    std::vector<T> sample;
+    if(size <= CARDINALITY_SAMPLE) { sample.assign(first, last); }
+    else {
+        std::mt19937_64 gen{size};
+        for(std::size_t i = 0; i < CARDINALITY_SAMPLE; ++i) { sample.push_back(first[gen() % size]); }
+    }
+    std::sort(sample.begin(), sample.end(), less);
+
+    CardinalityEstimate<T> ret;
+    std::size_t singletons = 0;
+    for(std::size_t i = 0; i < sample.size(); )
+    {
+        std::size_t j = i + 1;
+        while (j < sample.size() && !less(sample[i], sample[j])) { ++j; }
+        if(j - i == 1) { ++singletons; }
+        ret.keys.push_back(std::move(sample[i]));
+        i = j;
+    }
+
+    double scale = size <= CARDINALITY_SAMPLE ? 1 : std::sqrt(static_cast<double>(size) / CARDINALITY_SAMPLE);
+    ret.distinct = scale * singletons + (ret.keys.size() - singletons);
+    return ret;
+}
+
+/** Computes the heap memory countingSortByKeys uses besides the range.
+
+    @param size - the number of elements to be sorted
+    @param keys - the number of keys the sample found
+    @param threads - the number of threads sorting
+
+    @return - the size of the sample, the bucket of each element, the
+        counts and the scatter buffer, in bytes
+*/
+template<typename T>
+std::size_t
+countingSortExtraBytes (std::size_t size, std::size_t keys, std::size_t threads)
+{
+    std::size_t counts = std::max<std::size_t>(1, threads) * (2 * keys + 1) * sizeof(std::size_t);
+    return CARDINALITY_SAMPLE * sizeof(T) + size * (sizeof(std::uint32_t) + sizeof(T)) + counts;
+}
+
+/** Finds the first of the sorted keys not less than val, like
+    std::lower_bound, but adding the result of each comparison in place of a
+    branch on it, which the keys of shuffled data would mispredict half the
+    time.
+
+    @param keys - the distinct keys, in order
+    @param val - the value to look up
+    @param less - the ordering the keys are sorted by
+
+    @return - the index of that key, or keys.size() if there is none
+*/
+template<typename T, typename Compare>
+inline std::size_t
+keyIndex (const std::vector<T> &keys, const T &val, Compare less)
+{
+    if(keys.empty()) { return 0; }
+    const T* base = keys.data();
+    for(std::size_t n = keys.size(); n > 1; )
+    {
+        std::size_t half = n / 2;
+        base += half * static_cast<std::size_t>(less(base[half], val));
+        n -= half;
+    }
+    return (base - keys.data()) + (less(*base, val) ? 1 : 0);
+}
+
+/** Sorts [first, last) by counting, given the keys most of its elements
+    have. Bucket 2k + 1 holds the elements equal to keys[k], and bucket 2k
+    the elements the keys missed that fall between keys[k - 1] and keys[k].
+    Each thread finds the buckets of one chunk's elements by binary search
+    and counts them, then scatters its chunk to the buckets, which keeps the
+    sort stable.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param keys - the distinct keys, in order
+    @param less - the ordering to sort by
+    @param threads - the number of chunks, and of threads to use
+    @param sortGap - called as sortGap(begin, end), on the calling thread,
+        to sort each gap between two keys that holds elements
+    @param forEach - called as forEach(count, f), it must call f(i) for
+        every i in [0, count) in parallel and return once all have finished
+*/
+template<std::random_access_iterator Iter, typename Compare, typename SortGap, typename ForEach>
+void
+countingSortByKeys (Iter first, Iter last, const std::vector<std::iter_value_t<Iter>> &keys, Compare less,
+    std::size_t threads, const SortGap &sortGap, const ForEach &forEach)
+{
+    using T = std::iter_value_t<Iter>;
+
+    std::size_t size = std::distance(first, last);
+    std::size_t buckets = 2 * keys.size() + 1;
+    std::size_t chunks = std::max<std::size_t>(1, std::min(threads, size));
+    std::vector<std::uint32_t> bucketOf(size);
+    std::vector<std::size_t> counts(chunks * buckets, 0);
+
+    forEach(chunks, [&] (std::size_t c) {
+        std::size_t* count = counts.data() + c * buckets;
+        for(std::size_t i = c * size / chunks; i < (c + 1) * size / chunks; ++i)
+        {
+            std::size_t k = keyIndex(keys, first[i], less);
+            std::uint32_t b = 2 * k + (k < keys.size() && !less(first[i], keys[k]) ? 1 : 0);
+            bucketOf[i] = b;
+            ++count[b];
+        }
+    });
+
+    //each count becomes where its chunk's part of the bucket starts, with
+    //the buckets in order and each bucket's parts in chunk order
+    std::vector<std::size_t> bucketStart(buckets + 1);
+    std::size_t sum = 0;
+    for(std::size_t b = 0; b < buckets; ++b)
+    {
+        bucketStart[b] = sum;
+        for(std::size_t c = 0; c < chunks; ++c)
+        {
+            std::size_t count = counts[c * buckets + b];
+            counts[c * buckets + b] = sum;
+            sum += count;
+        }
+    }
+    bucketStart[buckets] = size;
+
+    std::vector<T> buffer(size);
+    forEach(chunks, [&] (std::size_t c) {
+        std::size_t* next = counts.data() + c * buckets;
+        for(std::size_t i = c * size / chunks; i < (c + 1) * size / chunks; ++i)
+        {
+            buffer[next[bucketOf[i]]++] = std::move(first[i]);
+        }
+    });
+    forEach(chunks, [&] (std::size_t c) {
+        std::move(buffer.begin() + c * size / chunks, buffer.begin() + (c + 1) * size / chunks, first + c * size / chunks);
+    });
+
+    for(std::size_t b = 0; b < buckets; b += 2)
+    {
+        if(bucketStart[b + 1] - bucketStart[b] > 1) { sortGap(first + bucketStart[b], first + bucketStart[b + 1]); }
+    }
+}
+
+/** Whether a range holds enough copies of its pivot for a 3-way partition
+    to pay for its extra work over a 2-way one.
+
+    @param begin - the start of the range
+    @param end - one past the end of the range
+    @param pivot - the value the range will be partitioned on
+    @param less - the ordering to partition by
+
+    @return - true if more than one of ADAPTIVE_PROBE evenly spaced
+        elements is equal to the pivot
+*/
+template<std::random_access_iterator Iter, typename Value, typename Compare>
+bool
+pivotRepeats (Iter begin, Iter end, const Value &pivot, Compare less)
+{
+    std::size_t size = std::distance(begin, end);
+    std::size_t step = std::max<std::size_t>(1, size / ADAPTIVE_PROBE);
+    unsigned equal = 0;
+    for(std::size_t i = 0; i < size; i += step)
+    {
+        if(!less(begin[i], pivot) && !less(pivot, begin[i])) { ++equal; }
+    }
+    return equal > 1;
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
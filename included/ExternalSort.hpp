@@ -0,0 +1,312 @@
+/*
+  Filename   : ExternalSort.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: An external (out-of-core) sort of a binary file of
+               elements, for files larger than memory. The file is read in
+               chunks that fit the memory budget, each chunk is sorted in
+               memory and written out as a sorted run, and the runs are
+               then merged into the output with a loser tree. The merge
+               reads the runs through mmap, asking the kernel to read ahead
+               a window of each run and to drop what is behind it, and
+               writes through two buffers, so one is written back while the
+               merge fills the other.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <future>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/************************************************************/
+// Local includes
+
+#include "Timer.hpp"
+#include "MultiwayMerge.hpp"
+
+/************************************************************/
+// Using declarations
+
+//the smallest read-ahead window, and write-back buffer, the merge uses
+//however small the budget
+const static std::size_t EXTERNAL_MIN_WINDOW_BYTES = 64 * 1024;
+
+/** Where the time of an external sort went. */
+struct ExternalTimes
+{
+    //reading, writing and waiting on the disk
+    double ioMs{0};
+    //sorting the chunks and merging the runs
+    double cpuMs{0};
+    //the number of sorted runs written
+    std::size_t runs{0};
+};
+
+/************************************************************/
+
+/** Prints the failed system call and its error, and exits. */
+inline void
+externalFailure (const std::string &what)
+{
+    std::cerr << std::format("External sort: {} failed: {}\n", what, std::strerror(errno));
+    exit(EXIT_FAILURE);
+}
+
+/** Writes all of [data, data + bytes) to fd, at its current offset. */
+inline void
+writeAll (int fd, const char* data, std::size_t bytes)
+{
+    while (bytes > 0)
+    {
+        ssize_t written = write(fd, data, bytes);
+        if(written < 0) { externalFailure("write"); }
+        data += written;
+        bytes -= written;
+    }
+}
+
+/** Reads all of [data, data + bytes) from fd, at offset. */
+inline void
+readAll (int fd, char* data, std::size_t bytes, off_t offset)
+{
+    while (bytes > 0)
+    {
+        ssize_t got = pread(fd, data, bytes, offset);
+        if(got <= 0) { externalFailure("read"); }
+        data += got;
+        bytes -= got;
+        offset += got;
+    }
+}
+
+/** Cuts a binary file of elements into sorted runs of at most chunk
+    elements each.
+
+    @param inputPath - the file to sort
+    @param runPath - returns the name of run r's file
+    @param chunk - the number of elements that fit the memory budget
+    @param sortChunk - called as sortChunk(first, last) to sort a chunk
+    @param times - where the time spent is added
+
+    @return - the number of elements of each run, in order
+*/
+template<typename T, typename RunPath, typename SortChunk>
+std::vector<std::size_t>
+writeSortedRuns (const std::string &inputPath, const RunPath &runPath, std::size_t chunk, const SortChunk &sortChunk,
+    ExternalTimes &times)
+{
+    int input = open(inputPath.c_str(), O_RDONLY);
+    if(input < 0) { externalFailure(std::format("opening {}", inputPath)); }
+    struct stat info;
+    fstat(input, &info);
+    std::size_t count = info.st_size / sizeof(T);
+    posix_fadvise(input, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    std::vector<std::size_t> runs;
+    std::vector<T> buffer(std::min(chunk, count));
+    //an empty file still makes one (empty) run
+    std::size_t start = 0;
+    do
+    {
+        std::size_t size = std::min(chunk, count - start);
+
+        Timer<> read;
+        readAll(input, reinterpret_cast<char*>(buffer.data()), size * sizeof(T), start * sizeof(T));
+        read.stop();
+
+        Timer<> sort;
+        sortChunk(buffer.begin(), buffer.begin() + size);
+        sort.stop();
+
+        Timer<> write;
+        int run = open(runPath(runs.size()).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(run < 0) { externalFailure(std::format("creating {}", runPath(runs.size()))); }
+        writeAll(run, reinterpret_cast<const char*>(buffer.data()), size * sizeof(T));
+        close(run);
+        write.stop();
+
+        times.ioMs += read.getElapsedMs() + write.getElapsedMs();
+        times.cpuMs += sort.getElapsedMs();
+        runs.push_back(size);
+        start += chunk;
+    } while (start < count);
+    close(input);
+    return runs;
+}
+
+/** Merges sorted run files into one output file.
+
+    @param runPath - returns the name of run r's file
+    @param runSizes - the number of elements of each run
+    @param outputPath - the file to write the merged runs to
+    @param budget - the memory budget, in bytes, which the read-ahead
+        windows and the write-back buffers share
+    @param less - the ordering the runs are sorted by
+    @param times - where the time spent is added
+*/
+template<typename T, typename RunPath, typename Compare>
+void
+mergeRunFiles (const RunPath &runPath, const std::vector<std::size_t> &runSizes, const std::string &outputPath,
+    std::size_t budget, Compare less, ExternalTimes &times)
+{
+    std::size_t k = runSizes.size();
+    const std::size_t page = sysconf(_SC_PAGESIZE);
+    //one window per run, and two for the write-back buffers
+    std::size_t window = std::max(EXTERNAL_MIN_WINDOW_BYTES, budget / (k + 2)) / page * page;
+
+    Timer<> mapping;
+    std::vector<std::pair<const T*, const T*>> runs(k);
+    for(std::size_t r = 0; r < k; ++r)
+    {
+        int fd = open(runPath(r).c_str(), O_RDONLY);
+        if(fd < 0) { externalFailure(std::format("opening {}", runPath(r))); }
+        void* mapped = mmap(nullptr, runSizes[r] * sizeof(T), PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapped == MAP_FAILED) { externalFailure("mmap"); }
+        close(fd);
+        madvise(mapped, runSizes[r] * sizeof(T), MADV_SEQUENTIAL);
+        runs[r] = {static_cast<const T*>(mapped), static_cast<const T*>(mapped) + runSizes[r]};
+    }
+    int output = open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(output < 0) { externalFailure(std::format("creating {}", outputPath)); }
+    mapping.stop();
+
+    //the first window of every run is read ahead now, and each later one
+    //when the merge reaches the one before it. Windows the merge is done
+    //with are dropped, which keeps the runs within the budget.
+    std::vector<std::size_t> advised(k, 0);
+    std::vector<std::size_t> dropped(k, 0);
+    auto readAhead = [&] (std::size_t r, std::size_t done) {
+        char* base = const_cast<char*>(reinterpret_cast<const char*>(runs[r].first));
+        std::size_t bytes = runSizes[r] * sizeof(T);
+        while (advised[r] < bytes && advised[r] <= done + window)
+        {
+            madvise(base + advised[r], std::min(window, bytes - advised[r]), MADV_WILLNEED);
+            advised[r] += window;
+        }
+        std::size_t behind = done / window * window;
+        if(behind > dropped[r])
+        {
+            madvise(base + dropped[r], behind - dropped[r], MADV_DONTNEED);
+            dropped[r] = behind;
+        }
+    };
+    for(std::size_t r = 0; r < k; ++r) { readAhead(r, 0); }
+
+    std::size_t block = std::max<std::size_t>(1, window / sizeof(T));
+    std::vector<T> buffers[2] {std::vector<T>(block), std::vector<T>(block)};
+    std::future<void> pending;
+    double waited = 0;
+    auto writeBack = [&] (const std::vector<T> &buffer, std::size_t count) {
+        if(pending.valid())
+        {
+            Timer<> wait;
+            pending.get();
+            wait.stop();
+            waited += wait.getElapsedMs();
+        }
+        pending = std::async(std::launch::async, [output, &buffer, count] {
+            writeAll(output, reinterpret_cast<const char*>(buffer.data()), count * sizeof(T));
+        });
+    };
+
+    Timer<> merge;
+    LoserTree<const T*, Compare> tree(runs, less);
+    std::size_t total = 0;
+    for(std::size_t size : runSizes) { total += size; }
+
+    int cur = 0;
+    for(std::size_t done = 0; done < total; )
+    {
+        std::size_t count = std::min(block, total - done);
+        for(std::size_t i = 0; i < count; ++i) { tree.pop(buffers[cur].begin() + i); }
+        done += count;
+        for(std::size_t r = 0; r < k; ++r)
+        {
+            readAhead(r, (tree.sources[r].first - runs[r].first) * sizeof(T));
+        }
+        writeBack(buffers[cur], count);
+        cur ^= 1;
+    }
+    merge.stop();
+
+    Timer<> flush;
+    if(pending.valid()) { pending.get(); }
+    fdatasync(output);
+    close(output);
+    for(std::size_t r = 0; r < k; ++r)
+    {
+        munmap(const_cast<T*>(runs[r].first), runSizes[r] * sizeof(T));
+    }
+    flush.stop();
+
+    times.ioMs += mapping.getElapsedMs() + waited + flush.getElapsedMs();
+    times.cpuMs += merge.getElapsedMs() - waited;
+}
+
+/** Sorts a binary file of elements of type T into another file, using at
+    most about budget bytes of memory.
+
+    NOTE: the sorted runs are written next to the output, as
+    "<outputPath>.run<r>", and removed once merged
+
+    @param inputPath - the file to sort, in native byte order
+    @param outputPath - the file to write the sorted elements to
+    @param budget - the memory to use, in bytes
+    @param less - the ordering to sort by
+    @param sortChunk - called as sortChunk(first, last) to sort a chunk in
+        memory
+
+    @return - the time spent on I/O and on sorting, and the number of runs
+*/
+template<typename T, typename Compare, typename SortChunk>
+ExternalTimes
+externalSort (const std::string &inputPath, const std::string &outputPath, std::size_t budget, Compare less,
+    const SortChunk &sortChunk)
+{
+    ExternalTimes times;
+    std::size_t chunk = std::max<std::size_t>(1, budget / sizeof(T));
+
+    //a file that fits the budget is one run, written straight to the output
+    struct stat info;
+    if(stat(inputPath.c_str(), &info) != 0) { externalFailure(std::format("opening {}", inputPath)); }
+    bool oneRun = static_cast<std::size_t>(info.st_size) / sizeof(T) <= chunk;
+
+    auto runPath = [&] (std::size_t r) {
+        return oneRun ? outputPath : std::format("{}.run{}", outputPath, r);
+    };
+    auto runSizes = writeSortedRuns<T>(inputPath, runPath, chunk, sortChunk, times);
+    times.runs = runSizes.size();
+    if(oneRun) { return times; }
+
+    mergeRunFiles<T>(runPath, runSizes, outputPath, budget, less, times);
+    for(std::size_t r = 0; r < runSizes.size(); ++r) { std::remove(runPath(r).c_str()); }
+    return times;
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
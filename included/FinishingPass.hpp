@@ -0,0 +1,150 @@
+/*
+  Filename   : FinishingPass.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: The deferred small-sort. Quicksort leaves ranges below the
+               cutoff unsorted, and a single insertion pass over the whole
+               array sorts them afterwards. Only the first cutoff + 1
+               elements need a bounds check, as the minimum of the array is
+               among them and stops every later insertion.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef FINISHING_PASS_H
+#define FINISHING_PASS_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+/************************************************************/
+// Local includes
+
+/************************************************************/
+// Using declarations
+
+/************************************************************/
+
+/** Sorts [first, last) with insertion sort, checking for the start of the
+    range.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param less - the ordering to sort by
+*/
+template<std::random_access_iterator Iter, typename Compare>
+void
+insertionPass (Iter first, Iter last, Compare less)
+{
+    if(std::distance(first, last) < 2) { return; }
+
+    for(Iter cur = std::next(first); cur != last; ++cur)
+    {
+        auto key = std::move(*cur);
+        Iter hole = cur;
+        while (hole != first && less(key, *std::prev(hole)))
+        {
+            *hole = std::move(*std::prev(hole));
+            --hole;
+        }
+        *hole = std::move(key);
+    }
+}
+
+/** Sorts [first, last) with insertion sort, without checking for the start
+    of the range.
+
+    NOTE: some element before first must not be greater than any element in
+    the range, as it is what stops the inner loop.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param less - the ordering to sort by
+*/
+template<std::random_access_iterator Iter, typename Compare>
+void
+unguardedInsertionPass (Iter first, Iter last, Compare less)
+{
+    for(Iter cur = first; cur != last; ++cur)
+    {
+        auto key = std::move(*cur);
+        Iter hole = cur;
+        while (less(key, *std::prev(hole)))
+        {
+            *hole = std::move(*std::prev(hole));
+            --hole;
+        }
+        *hole = std::move(key);
+    }
+}
+
+/** Sorts a range whose unsorted blocks are each at most cutoff elements
+    long and already in order relative to each other.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param cutoff - the largest unsorted block
+    @param less - the ordering to sort by
+*/
+template<std::random_access_iterator Iter, typename Compare>
+void
+finishingPass (Iter first, Iter last, std::size_t cutoff, Compare less)
+{
+    std::size_t size = std::distance(first, last);
+    Iter guarded = first + std::min(size, cutoff + 1);
+    insertionPass(first, guarded, less);
+    unguardedInsertionPass(guarded, last, less);
+}
+
+/** The parallel version of finishingPass. The array is split into one chunk
+    per thread, and each chunk is finished on its own. A block that
+    straddles a chunk boundary ends up sorted in two halves, so a window of
+    cutoff elements on either side of each boundary is then sorted again.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param cutoff - the largest unsorted block
+    @param less - the ordering to sort by
+    @param threads - the number of chunks, and of threads to use
+    @param forEach - called as forEach(count, f), it must call f(i) for
+        every i in [0, count) in parallel and return once all have finished
+*/
+template<std::random_access_iterator Iter, typename Compare, typename ForEach>
+void
+finishingPass (Iter first, Iter last, std::size_t cutoff, Compare less, std::size_t threads, const ForEach &forEach)
+{
+    std::size_t size = std::distance(first, last);
+    std::size_t chunks = std::max<std::size_t>(1, threads);
+    std::size_t chunkSize = (size + chunks - 1) / chunks;
+
+    //the boundary windows must not overlap each other
+    if(chunks == 1 || chunkSize < 2 * (cutoff + 1))
+    {
+        finishingPass(first, last, cutoff, less);
+        return;
+    }
+
+    forEach(chunks, [=] (std::size_t i) {
+        std::size_t start = std::min(i * chunkSize, size);
+        std::size_t stop = std::min(start + chunkSize, size);
+        finishingPass(first + start, first + stop, cutoff, less);
+    });
+    forEach(chunks - 1, [=] (std::size_t i) {
+        std::size_t boundary = (i + 1) * chunkSize;
+        if(boundary >= size) { return; }
+        insertionPass(first + (boundary - cutoff), first + std::min(boundary + cutoff, size), less);
+    });
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
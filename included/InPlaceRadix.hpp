@@ -0,0 +1,185 @@
+/*
+  Filename   : InPlaceRadix.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: In-place most significant digit radix sort for unsigned
+               integer keys, in the style of IPS2Ra. Buckets larger than a
+               thread's share of the array are distributed by every thread
+               with blockDistribute. The rest are handed out to the threads
+               whole and sorted with an American flag sort, which permutes
+               elements into their buckets by following swap cycles and so
+               needs no buffer at all.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef IN_PLACE_RADIX_H
+#define IN_PLACE_RADIX_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/************************************************************/
+// Local includes
+
+#include "BlockDistribution.hpp"
+#include "FinishingPass.hpp"
+#include "RadixSort.hpp"
+
+/************************************************************/
+// Using declarations
+
+//the digit width of the MSD sorts, one byte per level
+const static unsigned MSD_DIGIT_BITS = 8;
+const static std::size_t MSD_RADIX = std::size_t{1} << MSD_DIGIT_BITS;
+
+/************************************************************/
+
+/** Sorts [first, last) by the unsigned key keyOf returns, starting at
+    digit (counted from the least significant one) and moving down. Digits
+    that are the same for every element are skipped.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param keyOf - extracts the unsigned key of an element
+    @param digit - the most significant digit that may still differ
+    @param cutoff - the size at or below which insertion sort is used
+*/
+template<std::random_access_iterator Iter, typename KeyOf>
+void
+americanFlagSort (Iter first, Iter last, KeyOf keyOf, int digit, std::size_t cutoff)
+{
+    auto byKey = [&] (const auto &a, const auto &b) { return std::invoke(keyOf, a) < std::invoke(keyOf, b); };
+    auto digitAt = [&] (const auto &val) { return digitOf<MSD_DIGIT_BITS>(std::invoke(keyOf, val), digit); };
+
+    std::size_t size = std::distance(first, last);
+    if(size < 2) { return; }
+
+    std::array<std::size_t, MSD_RADIX> counts;
+    for(; digit >= 0; --digit)
+    {
+        if(size <= cutoff)
+        {
+            insertionPass(first, last, byKey);
+            return;
+        }
+
+        counts.fill(0);
+        for(Iter cur = first; cur != last; ++cur) { ++counts[digitAt(*cur)]; }
+        if(counts[digitAt(*first)] != size) { break; }
+    }
+    if(digit < 0) { return; }
+
+    std::array<std::size_t, MSD_RADIX> heads;
+    std::array<std::size_t, MSD_RADIX> tails;
+    std::size_t sum = 0;
+    for(std::size_t b = 0; b < MSD_RADIX; ++b)
+    {
+        heads[b] = sum;
+        sum += counts[b];
+        tails[b] = sum;
+    }
+
+    //follow each swap cycle until an element that belongs in bucket b
+    //comes back around
+    for(std::size_t b = 0; b < MSD_RADIX; ++b)
+    {
+        while (heads[b] < tails[b])
+        {
+            auto val = std::move(first[heads[b]]);
+            std::size_t dest = digitAt(val);
+            while (dest != b)
+            {
+                std::swap(val, first[heads[dest]++]);
+                dest = digitAt(val);
+            }
+            first[heads[b]++] = std::move(val);
+        }
+    }
+
+    if(digit == 0) { return; }
+    std::size_t start = 0;
+    for(std::size_t b = 0; b < MSD_RADIX; ++b)
+    {
+        americanFlagSort(first + start, first + tails[b], keyOf, digit - 1, cutoff);
+        start = tails[b];
+    }
+}
+
+/** Sorts [first, last) by the unsigned key keyOf returns, in parallel and
+    in place. Buckets larger than size / threads are distributed again by
+    every thread, and smaller ones are sorted by one thread each, largest
+    first.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param keyOf - extracts the unsigned key of an element
+    @param cutoff - the size at or below which insertion sort is used
+    @param threads - the number of threads to use
+    @param forEach - called as forEach(count, f), it must call f(i) for
+        every i in [0, count) in parallel and return once all have finished
+*/
+template<std::random_access_iterator Iter, typename KeyOf, typename ForEach>
+void
+msdRadixSort (Iter first, Iter last, KeyOf keyOf, std::size_t cutoff, std::size_t threads, const ForEach &forEach)
+{
+    using Key = RadixKey<std::iter_value_t<Iter>, KeyOf>;
+    const int TOP = digitCount<Key>(MSD_DIGIT_BITS) - 1;
+
+    std::size_t size = std::distance(first, last);
+    std::size_t bigSize = size / std::max<std::size_t>(1, threads);
+
+    std::vector<std::tuple<Iter, Iter, int>> big;
+    std::vector<std::tuple<Iter, Iter, int>> small;
+    if(threads > 1 && size > cutoff) { big.emplace_back(first, last, TOP); }
+    else { small.emplace_back(first, last, TOP); }
+
+    while (!big.empty())
+    {
+        auto [begin, end, digit] = big.back();
+        big.pop_back();
+
+        auto bounds = blockDistribute(begin, end, MSD_RADIX, [&, digit] (const auto &val) {
+            return digitOf<MSD_DIGIT_BITS>(std::invoke(keyOf, val), digit);
+        }, threads, forEach);
+        if(digit == 0) { continue; }
+
+        for(std::size_t b = 0; b < MSD_RADIX; ++b)
+        {
+            std::size_t bucketSize = bounds[b + 1] - bounds[b];
+            if(bucketSize < 2) { continue; }
+            auto &tasks = bucketSize > bigSize && bucketSize > cutoff ? big : small;
+            tasks.emplace_back(begin + bounds[b], begin + bounds[b + 1], digit - 1);
+        }
+    }
+
+    std::sort(small.begin(), small.end(), [] (const auto &a, const auto &b) {
+        return std::get<1>(a) - std::get<0>(a) > std::get<1>(b) - std::get<0>(b);
+    });
+    std::atomic<std::size_t> next{0};
+    forEach(threads, [&] (std::size_t) {
+        for(std::size_t task = next++; task < small.size(); task = next++)
+        {
+            auto [begin, end, digit] = small[task];
+            americanFlagSort(begin, end, keyOf, digit, cutoff);
+        }
+    });
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
@@ -0,0 +1,82 @@
+/*
+  Filename   : Introsort.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: The recursion depth guard used by the quicksorts. Each sort is
+               given a budget of 2*log2(n) levels, and any range that is still
+               unsorted when the budget runs out is heapsorted instead, which
+               bounds both the running time and the stack depth. A sort
+               that must be stable merge sorts those ranges instead.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef INTROSORT_H
+#define INTROSORT_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+
+/************************************************************/
+// Local includes
+
+/************************************************************/
+// Using declarations
+
+//the number of ranges that were heapsorted in the current run. Shared by
+//every thread, so that the parallel sorts report the total.
+inline std::atomic<unsigned> heapsortFallbacks{0};
+
+//set before sorting when equal elements must keep their order, as a
+//heapsort would not
+inline bool stableFallback{false};
+
+/************************************************************/
+
+/** Computes the recursion depth budget for a range of size elements.
+
+    @param size - the number of elements to be sorted
+
+    @return - 2 * floor(log2(size)), or 0 for an empty range
+*/
+inline unsigned
+depthBudget (std::size_t size)
+{
+    return 2 * (std::bit_width(size) - 1 + (size == 0));
+}
+
+/** Heapsorts the range [begin, end) and records that the fallback fired.
+    If stableFallback is set, the range is merge sorted instead, which is
+    also O(n log n).
+
+    @param begin - the start of the range to be sorted
+    @param end - the end (exclusive) of the range to be sorted
+    @param less - the ordering to sort by
+*/
+template<std::random_access_iterator Iter, typename Compare>
+void
+heapsortFallback (Iter begin, Iter end, Compare less)
+{
+    heapsortFallbacks.fetch_add(1, std::memory_order_relaxed);
+    if(stableFallback)
+    {
+        std::stable_sort(begin, end, less);
+        return;
+    }
+    std::make_heap(begin, end, less);
+    std::sort_heap(begin, end, less);
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
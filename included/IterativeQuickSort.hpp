@@ -0,0 +1,140 @@
+/*
+  Filename   : IterativeQuickSort.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: A quicksort driver that keeps its pending ranges on an
+               explicit, fixed-size stack instead of the call stack. After
+               each partition it carries on with the smallest part and
+               pushes the others, largest first, so that the larger ones
+               sit deeper. The stack then stays within 1.5 log2(n) frames
+               whatever the input, and a range that would overflow it is
+               heapsorted instead.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef ITERATIVE_QUICKSORT_H
+#define ITERATIVE_QUICKSORT_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+
+/************************************************************/
+// Local includes
+
+#include "Introsort.hpp"
+
+/************************************************************/
+// Using declarations
+
+//a partition of a range of size s pushes its other parts largest first, so
+//while j of them are still on the stack, the range being sorted is at most
+//s / (j + 1), being no larger than any of them. With at most 4 parts, that
+//is at most 3 frames per quartering, 1.5 frames per halving, or 96 frames
+//for any range a 64-bit size can hold.
+const static std::size_t QUICKSORT_STACK_FRAMES = 96;
+
+//the deepest any iterative quicksort's stack got in the current run. Shared
+//by every thread, so that the parallel sorts report the overall maximum.
+inline std::atomic<unsigned> maxStackDepth{0};
+
+/************************************************************/
+
+/** Raises maxStackDepth to depth, if it is deeper. */
+inline void
+recordStackDepth (unsigned depth)
+{
+    unsigned seen = maxStackDepth.load(std::memory_order_relaxed);
+    while (seen < depth && !maxStackDepth.compare_exchange_weak(seen, depth, std::memory_order_relaxed)) {}
+}
+
+/** Sorts [begin, end) with quicksort, without recursion. Ranges at or below
+    the cutoff go to sortSmall, and ranges still unsorted when their budget
+    runs out are heapsorted.
+
+    @param begin - the start of the range to be sorted
+    @param end - the end (exclusive) of the range to be sorted
+    @param cutoff - the size at or below which sortSmall is used
+    @param budget - the number of partitioning levels left before a range
+        is heapsorted instead
+    @param less - the ordering to sort by
+    @param sortSmall - called as sortSmall(first, last) on ranges at or
+        below the cutoff
+    @param split - called as split(first, last) on larger ranges, it must
+        partition the range and return the Segments that are left to sort
+*/
+template<std::random_access_iterator Iter, typename Compare, typename SortSmall, typename Split>
+void
+quickSortLoop (Iter begin, Iter end, std::size_t cutoff, unsigned budget, Compare less, const SortSmall &sortSmall,
+    const Split &split)
+{
+    struct Frame
+    {
+        Iter begin;
+        Iter end;
+        unsigned budget;
+    };
+    std::array<Frame, QUICKSORT_STACK_FRAMES> stack;
+    std::size_t top = 0;
+    std::size_t deepest = 0;
+
+    Frame cur{begin, end, budget};
+    while (true)
+    {
+        std::size_t size = std::distance(cur.begin, cur.end);
+        if(size <= cutoff) { sortSmall(cur.begin, cur.end); }
+        else if(cur.budget == 0) { heapsortFallback(cur.begin, cur.end, less); }
+        else {
+            auto parts = split(cur.begin, cur.end);
+            if(parts.count > 0)
+            {
+                //largest first, so the smallest is carried on with. There
+                //are at most 4 parts, so an insertion sort does
+                auto sorted = parts.ranges;
+                for(int i = 1; i < parts.count; ++i)
+                {
+                    auto part = sorted[i];
+                    int j = i;
+                    for(; j > 0 && std::distance(sorted[j - 1].first, sorted[j - 1].second) < std::distance(part.first, part.second); --j)
+                    {
+                        sorted[j] = sorted[j - 1];
+                    }
+                    sorted[j] = part;
+                }
+                //cannot happen within the bound above, but an overflow would
+                //corrupt the call stack
+                if(top + parts.count - 1 > QUICKSORT_STACK_FRAMES)
+                {
+                    heapsortFallback(cur.begin, cur.end, less);
+                }
+                else {
+                    for(int i = 0; i < parts.count - 1; ++i)
+                    {
+                        stack[top++] = {sorted[i].first, sorted[i].second, cur.budget - 1};
+                    }
+                    deepest = std::max(deepest, top);
+                    cur = {sorted[parts.count - 1].first, sorted[parts.count - 1].second, cur.budget - 1};
+                    continue;
+                }
+            }
+        }
+
+        if(top == 0) { break; }
+        cur = stack[--top];
+    }
+    recordStackDepth(deepest);
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
@@ -0,0 +1,289 @@
+/*
+  Filename   : KeyNormalization.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: Maps signed and floating-point keys to unsigned integers in
+               the same order, so the radix sorts and the vectorized
+               partition, which only know unsigned integers, can sort them.
+               Signed integers have their sign bit flipped, and IEEE floats
+               have every bit flipped when negative and only the sign bit
+               when not. Fixed-width strings are compared a byte-swapped
+               8-byte word at a time, and radix sorted by their first word
+               with the runs sharing it sorted by comparison. The keys can
+               be normalized into a separate array, and restored from it,
+               in parallel passes that fuse the transform with the copy.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef KEY_NORMALIZATION_H
+#define KEY_NORMALIZATION_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+/************************************************************/
+// Local includes
+
+/************************************************************/
+// Using declarations
+
+//the number of keys one task normalizes or restores at a time
+const static std::size_t NORMALIZE_BLOCK = 16384;
+
+/** Loads the 8 bytes at bytes as a big-endian integer, so comparing two
+    loads compares their bytes in order.
+*/
+inline std::uint64_t
+loadBigEndian (const unsigned char* bytes)
+{
+    std::uint64_t ret;
+    std::memcpy(&ret, bytes, sizeof(ret));
+    if constexpr (std::endian::native == std::endian::little) { ret = __builtin_bswap64(ret); }
+    return ret;
+}
+
+/** A string of exactly N bytes, ordered byte by byte like memcmp. The
+    order is found a word at a time, comparing big-endian loads.
+
+    @param N - the length of the string, a multiple of 8
+*/
+template<std::size_t N>
+struct FixedString
+{
+    static_assert(N % 8 == 0 && N > 0);
+    std::array<unsigned char, N> chars{};
+
+    /** The w-th 8 bytes of the string as a big-endian integer. */
+    std::uint64_t
+    word (std::size_t w) const
+    {
+        return loadBigEndian(chars.data() + 8 * w);
+    }
+
+    std::strong_ordering
+    operator<=> (const FixedString &other) const
+    {
+        for(std::size_t w = 0; w < N / 8; ++w)
+        {
+            std::uint64_t a = word(w);
+            std::uint64_t b = other.word(w);
+            if(a != b) { return a <=> b; }
+        }
+        return std::strong_ordering::equal;
+    }
+
+    bool
+    operator== (const FixedString &other) const = default;
+};
+
+using String16 = FixedString<16>;
+
+/** True when T is one of the FixedStrings. */
+template<typename T>
+constexpr bool isFixedString = false;
+
+template<std::size_t N>
+constexpr bool isFixedString<FixedString<N>> = true;
+
+/** True when T is a key that must be normalized before being sorted as an
+    unsigned integer: a signed integer, a float or a double.
+*/
+template<typename T>
+constexpr bool needsNormalizing = (std::is_integral_v<T> && std::is_signed_v<T>) || std::is_same_v<T, float>
+    || std::is_same_v<T, double>;
+
+/************************************************************/
+
+/** Maps key to an unsigned integer of the same width, such that the
+    integers are in the same order as the keys.
+
+    NOTE: -0.0 comes before 0.0, and NaNs come after the infinity of their
+    sign, so floats are in the IEEE total order rather than that of <
+
+    @param key - the key to map
+
+    @return - key itself if it is unsigned, key with its sign bit flipped
+        if it is signed, and for floats, the bits of key all flipped if it
+        is negative or with the sign bit set if not
+*/
+template<typename T>
+    requires std::is_arithmetic_v<T>
+constexpr auto
+normalizeKey (T key)
+{
+    if constexpr (std::is_unsigned_v<T>) { return key; }
+    else if constexpr (std::is_integral_v<T>)
+    {
+        using U = std::make_unsigned_t<T>;
+        return static_cast<U>(static_cast<U>(key) ^ (U{1} << (8 * sizeof(T) - 1)));
+    }
+    else {
+        using U = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+        U bits = std::bit_cast<U>(key);
+        U sign = U{1} << (8 * sizeof(T) - 1);
+        return static_cast<U>((bits & sign) ? ~bits : bits | sign);
+    }
+}
+
+/** Maps a fixed-width string to the big-endian integer of its first 8
+    bytes, which orders strings by their prefix. A radix sort by this key
+    leaves only the strings that share a prefix to sortEqualPrefixes.
+
+    @param key - the string to map
+
+    @return - the first word of key
+*/
+template<std::size_t N>
+constexpr std::uint64_t
+normalizeKey (const FixedString<N> &key)
+{
+    return key.word(0);
+}
+
+/** Undoes normalizeKey.
+
+    @param key - the unsigned integer normalizeKey returned for a T
+
+    @return - the T it was made from
+*/
+template<typename T, typename U>
+constexpr T
+denormalizeKey (U key)
+{
+    if constexpr (std::is_unsigned_v<T>) { return key; }
+    else if constexpr (std::is_integral_v<T>) { return static_cast<T>(key ^ (U{1} << (8 * sizeof(T) - 1))); }
+    else {
+        U sign = U{1} << (8 * sizeof(T) - 1);
+        return std::bit_cast<T>(static_cast<U>((key & sign) ? key ^ sign : ~key));
+    }
+}
+
+/** The unsigned integer normalizeKey maps a T to. */
+template<typename T>
+using NormalizedKeyType = decltype(normalizeKey(std::declval<const T &>()));
+
+/** A projection giving an element's normalized key, which lets the radix
+    sorts take signed and floating-point keys.
+*/
+struct NormalizedKey
+{
+    template<typename T>
+    constexpr auto
+    operator() (const T &key) const
+    {
+        return normalizeKey(key);
+    }
+};
+
+/** Finishes sorting fixed-width strings that were sorted by normalizeKey,
+    their first 8 bytes. Each run of strings sharing those bytes is sorted
+    by comparing the whole strings.
+
+    @param first - the start of the strings, sorted by prefix
+    @param last - the end (exclusive) of the strings
+*/
+template<std::random_access_iterator Iter>
+    requires isFixedString<std::iter_value_t<Iter>>
+void
+sortEqualPrefixes (Iter first, Iter last)
+{
+    while (first != last)
+    {
+        std::uint64_t prefix = normalizeKey(*first);
+        Iter run = std::find_if(std::next(first), last, [prefix] (const auto &str) {
+            return normalizeKey(str) != prefix;
+        });
+        if(std::distance(first, run) > 1) { std::sort(first, run); }
+        first = run;
+    }
+}
+
+/************************************************************/
+
+/** Writes the normalized key of every element of [first, last) to out.
+
+    @param first - the start of the keys
+    @param last - the end (exclusive) of the keys
+    @param out - the start of the array to write the normalized keys to
+    @param forEach - called as forEach(count, f), it must call f(i) for
+        every i in [0, count) in parallel and return once all have finished
+*/
+template<std::random_access_iterator Iter, std::random_access_iterator OutIter, typename ForEach>
+void
+normalizeKeys (Iter first, Iter last, OutIter out, const ForEach &forEach)
+{
+    std::size_t size = std::distance(first, last);
+    forEach((size + NORMALIZE_BLOCK - 1) / NORMALIZE_BLOCK, [&] (std::size_t b) {
+        for(std::size_t i = b * NORMALIZE_BLOCK; i < std::min(size, (b + 1) * NORMALIZE_BLOCK); ++i)
+        {
+            out[i] = normalizeKey(first[i]);
+        }
+    });
+}
+
+/** Writes the key every normalized key of [first, last) was made from to
+    out, undoing normalizeKeys.
+
+    @param first - the start of the normalized keys
+    @param last - the end (exclusive) of the normalized keys
+    @param out - the start of the array of keys to write to
+    @param forEach - called as forEach(count, f), as for normalizeKeys
+*/
+template<std::random_access_iterator Iter, std::random_access_iterator OutIter, typename ForEach>
+void
+denormalizeKeys (Iter first, Iter last, OutIter out, const ForEach &forEach)
+{
+    using T = std::iter_value_t<OutIter>;
+
+    std::size_t size = std::distance(first, last);
+    forEach((size + NORMALIZE_BLOCK - 1) / NORMALIZE_BLOCK, [&] (std::size_t b) {
+        for(std::size_t i = b * NORMALIZE_BLOCK; i < std::min(size, (b + 1) * NORMALIZE_BLOCK); ++i)
+        {
+            out[i] = denormalizeKey<T>(first[i]);
+        }
+    });
+}
+
+/** Sorts the signed or floating-point keys [first, last) as unsigned
+    integers. They are normalized into a buffer, the buffer is sorted, and
+    the keys are restored from it over the range.
+
+    @param first - the start of the keys to be sorted
+    @param last - the end (exclusive) of the keys to be sorted
+    @param sortKeys - called as sortKeys(begin, end) to sort the normalized
+        keys, which are held in an array, by <
+    @param forEach - called as forEach(count, f), as for normalizeKeys
+*/
+template<std::random_access_iterator Iter, typename SortKeys, typename ForEach>
+void
+sortNormalized (Iter first, Iter last, const SortKeys &sortKeys, const ForEach &forEach)
+{
+    using Key = NormalizedKeyType<std::iter_value_t<Iter>>;
+
+    std::size_t size = std::distance(first, last);
+    //left uninitialized, as the first pass writes every key
+    std::unique_ptr<Key[]> keys(new Key[size]);
+    normalizeKeys(first, last, keys.get(), forEach);
+    sortKeys(keys.get(), keys.get() + size);
+    denormalizeKeys(keys.get(), keys.get() + size, first, forEach);
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
@@ -0,0 +1,240 @@
+/*
+  Filename   : MultiPivot.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: Dual-pivot (Yaroslavskiy) and 3-pivot (Kushagra et al.)
+               partitioning kernels. Both split a range into more than two
+               parts in a single pass, so fewer passes over memory are needed
+               to sort a large array. Pivots are chosen from evenly spaced
+               samples of the range, so the pivot policies do not apply.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef MULTI_PIVOT_H
+#define MULTI_PIVOT_H
+
+/************************************************************/
+// System includes
+
+#include <array>
+#include <iterator>
+#include <utility>
+
+/************************************************************/
+// Local includes
+
+/************************************************************/
+// Using declarations
+
+/** The ranges left to sort after a multi-pivot partition. Pivots, and any
+    range made up only of elements equal to a pivot, are already in place
+    and are not included.
+*/
+template<std::random_access_iterator Iter>
+struct Segments
+{
+    std::array<std::pair<Iter, Iter>, 4> ranges{};
+    int count{0};
+
+    void
+    add (Iter first, Iter last)
+    {
+        if(std::distance(first, last) > 1) { ranges[count++] = {first, last}; }
+    }
+
+    auto begin () const { return ranges.begin(); }
+    auto end () const { return ranges.begin() + count; }
+};
+
+/************************************************************/
+
+/** Partitions [begin, end) around two pivots p <= q, taken from the
+    tertiles of the range.
+
+    @param begin - the start of the range to partition
+    @param end - one past the end of the range to partition
+    @param less - the ordering to partition by
+
+    @return - the ranges holding elements less than p, between p and q, and
+        greater than q
+*/
+template<std::random_access_iterator Iter, typename Compare>
+Segments<Iter>
+dualPivotPartition (Iter begin, Iter end, Compare less)
+{
+    Segments<Iter> ret;
+    auto size = std::distance(begin, end);
+    if(size < 2) { return ret; }
+
+    Iter last = std::prev(end);
+    if(size >= 5)
+    {
+        std::iter_swap(begin, begin + size / 3);
+        std::iter_swap(last, begin + 2 * size / 3);
+    }
+    if(less(*last, *begin)) { std::iter_swap(begin, last); }
+
+    auto p = *begin;
+    auto q = *last;
+
+    //[begin + 1, low) < p, [low, cur) in [p, q], (great, last) > q
+    Iter low = std::next(begin);
+    Iter great = std::prev(last);
+    for(Iter cur = low; cur <= great; ++cur)
+    {
+        if(less(*cur, p))
+        {
+            std::iter_swap(cur, low);
+            ++low;
+        }
+        else if(less(q, *cur))
+        {
+            while (less(q, *great) && cur < great) { --great; }
+            std::iter_swap(cur, great);
+            --great;
+            if(less(*cur, p))
+            {
+                std::iter_swap(cur, low);
+                ++low;
+            }
+        }
+    }
+
+    //move the pivots into their final places
+    --low;
+    ++great;
+    std::iter_swap(begin, low);
+    std::iter_swap(last, great);
+
+    ret.add(begin, low);
+    //when the middle holds most of the range, the pivots are probably
+    //duplicated, so gather the copies of each pivot next to it
+    Iter midFirst = std::next(low);
+    Iter midLast = great;
+    if(less(p, q) && std::distance(midFirst, midLast) > size / 2)
+    {
+        for(Iter cur = midFirst; cur < midLast; ++cur)
+        {
+            if(!less(p, *cur))
+            {
+                std::iter_swap(cur, midFirst);
+                ++midFirst;
+            }
+            else if(!less(*cur, q))
+            {
+                --midLast;
+                std::iter_swap(cur, midLast);
+                --cur;
+            }
+        }
+    }
+    if(less(p, q)) { ret.add(midFirst, midLast); }
+    ret.add(std::next(great), end);
+    return ret;
+}
+
+/** Partitions [begin, end) around three pivots p <= q <= r, taken from the
+    quartiles of the range. Ranges too small to sample use the dual-pivot
+    partition.
+
+    @param begin - the start of the range to partition
+    @param end - one past the end of the range to partition
+    @param less - the ordering to partition by
+
+    @return - the ranges holding elements less than p, between p and q,
+        between q and r, and greater than r
+*/
+template<std::random_access_iterator Iter, typename Compare>
+Segments<Iter>
+threePivotPartition (Iter begin, Iter end, Compare less)
+{
+    auto size = std::distance(begin, end);
+    if(size < 8) { return dualPivotPartition(begin, end, less); }
+
+    //sort the quartiles and move them to begin, begin + 1 and last
+    Iter last = std::prev(end);
+    Iter first = begin + size / 4, second = begin + size / 2, third = begin + 3 * size / 4;
+    if(less(*second, *first)) { std::iter_swap(first, second); }
+    if(less(*third, *second)) { std::iter_swap(second, third); }
+    if(less(*second, *first)) { std::iter_swap(first, second); }
+    std::iter_swap(begin, first);
+    std::iter_swap(std::next(begin), second);
+    std::iter_swap(last, third);
+
+    auto p = *begin;
+    auto q = *std::next(begin);
+    auto r = *last;
+
+    //[begin + 2, a) < p, [a, b) in [p, q], (c, d] in [q, r], (d, last) > r
+    Iter a = begin + 2, b = begin + 2;
+    Iter c = last - 1, d = last - 1;
+    while (b <= c)
+    {
+        while (b <= c && less(*b, q))
+        {
+            if(less(*b, p))
+            {
+                std::iter_swap(a, b);
+                ++a;
+            }
+            ++b;
+        }
+        while (b <= c && less(q, *c))
+        {
+            if(less(r, *c))
+            {
+                std::iter_swap(c, d);
+                --d;
+            }
+            --c;
+        }
+        if(b <= c)
+        {
+            //*b belongs right of q and *c belongs left of it
+            bool bGreater = less(r, *b);
+            if(less(*c, p))
+            {
+                std::iter_swap(b, a);
+                std::iter_swap(a, c);
+                ++a;
+            }
+            else {
+                std::iter_swap(b, c);
+            }
+            if(bGreater)
+            {
+                std::iter_swap(c, d);
+                --d;
+            }
+            ++b;
+            --c;
+        }
+    }
+
+    //move the pivots into their final places
+    --a;
+    --b;
+    ++c;
+    ++d;
+    std::iter_swap(std::next(begin), a);
+    std::iter_swap(a, b);
+    --a;
+    std::iter_swap(begin, a);
+    std::iter_swap(last, d);
+
+    Segments<Iter> ret;
+    ret.add(begin, a);
+    if(less(p, q)) { ret.add(std::next(a), b); }
+    if(less(q, r)) { ret.add(std::next(b), d); }
+    ret.add(std::next(d), end);
+    return ret;
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
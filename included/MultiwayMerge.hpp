@@ -0,0 +1,235 @@
+/*
+  Filename   : MultiwayMerge.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: A parallel multiway mergesort. The range is cut into one
+               chunk per thread and each chunk is sorted on its own. The
+               output is then cut into one block per thread, and the sorted
+               chunks are split exactly at each block's first and last
+               rank, so every thread merges the same number of elements
+               whatever the data. Each thread merges its pieces of the
+               chunks with a loser tree, which takes log2(chunks)
+               comparisons per element.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef MULTIWAY_MERGE_H
+#define MULTIWAY_MERGE_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+/************************************************************/
+// Local includes
+
+/************************************************************/
+// Using declarations
+
+/** A tournament tree over sorted sources that keeps the loser of each
+    match in the inner nodes. Taking the smallest head only replays the
+    matches on the winner's path to the root.
+
+    @param Iter - the iterator type of the sources
+    @param Compare - the ordering to merge by
+*/
+template<std::random_access_iterator Iter, typename Compare>
+struct LoserTree
+{
+    //the remaining part of each source, padded to a power of two with
+    //empty ones
+    std::vector<std::pair<Iter, Iter>> sources;
+    //tree[0] is the overall winner, and tree[1 .. leaves) the losers
+    std::vector<std::size_t> tree;
+    std::size_t leaves;
+    Compare less;
+
+    LoserTree (const std::vector<std::pair<Iter, Iter>> &runs, Compare less)
+        : sources(runs), leaves(std::bit_ceil(std::max<std::size_t>(1, runs.size()))), less(less)
+    {
+        Iter end = runs.empty() ? Iter{} : runs.back().second;
+        sources.resize(leaves, {end, end});
+        tree.resize(leaves);
+        tree[0] = build(1);
+    }
+
+    /** Whether source a's head comes before source b's. Empty sources come
+        last, and equal heads go in source order, which keeps the merge
+        stable.
+    */
+    bool
+    beats (std::size_t a, std::size_t b) const
+    {
+        if(sources[a].first == sources[a].second) { return false; }
+        if(sources[b].first == sources[b].second) { return true; }
+        if(less(*sources[a].first, *sources[b].first)) { return true; }
+        return a < b && !less(*sources[b].first, *sources[a].first);
+    }
+
+    std::size_t
+    build (std::size_t node)
+    {
+        if(node >= leaves) { return node - leaves; }
+        std::size_t left = build(2 * node);
+        std::size_t right = build(2 * node + 1);
+        if(beats(left, right))
+        {
+            tree[node] = right;
+            return left;
+        }
+        tree[node] = left;
+        return right;
+    }
+
+    /** Moves the smallest head to out and advances its source.
+
+        NOTE: some source must not be empty
+    */
+    template<typename OutIter>
+    void
+    pop (OutIter out)
+    {
+        std::size_t winner = tree[0];
+        *out = std::move(*sources[winner].first++);
+        for(std::size_t node = (winner + leaves) / 2; node > 0; node /= 2)
+        {
+            if(beats(tree[node], winner)) { std::swap(tree[node], winner); }
+        }
+        tree[0] = winner;
+    }
+};
+
+/************************************************************/
+
+/** Computes the heap memory multiwayMergeSort uses besides the range.
+
+    @param size - the number of elements to be sorted
+    @param threads - the number of threads sorting
+
+    @return - the size of the merge buffer and the loser trees, in bytes
+*/
+template<typename T>
+std::size_t
+multiwayMergeExtraBytes (std::size_t size, std::size_t threads)
+{
+    std::size_t leaves = std::bit_ceil(std::max<std::size_t>(1, threads));
+    std::size_t tree = leaves * (2 * sizeof(T*) + sizeof(std::size_t));
+    return threads > 1 ? size * sizeof(T) + threads * tree : 0;
+}
+
+/** Splits sorted sequences such that exactly rank elements are on the
+    left, and none of them comes after any element on the right in a
+    stable merge of the sequences.
+
+    @param seqs - the sorted sequences
+    @param rank - the number of elements to put on the left
+    @param less - the ordering the sequences are sorted by
+
+    @return - the number of elements of each sequence on the left
+*/
+template<std::random_access_iterator Iter, typename Compare>
+std::vector<std::size_t>
+multiSequenceSplit (const std::vector<std::pair<Iter, Iter>> &seqs, std::size_t rank, Compare less)
+{
+    //the position in the stable merge of the m-th element of sequence i.
+    //Ties go to the earlier sequence, so that is the elements of earlier
+    //sequences not greater than it, and of later ones less than it.
+    auto mergedRank = [&] (std::size_t i, std::size_t m) {
+        const auto &val = seqs[i].first[m];
+        std::size_t ret = m;
+        for(std::size_t j = 0; j < seqs.size(); ++j)
+        {
+            if(j < i) { ret += std::upper_bound(seqs[j].first, seqs[j].second, val, less) - seqs[j].first; }
+            if(j > i) { ret += std::lower_bound(seqs[j].first, seqs[j].second, val, less) - seqs[j].first; }
+        }
+        return ret;
+    };
+
+    //the merged ranks rise along each sequence, so binary search for the
+    //first one at or past rank
+    std::vector<std::size_t> ret(seqs.size());
+    for(std::size_t i = 0; i < seqs.size(); ++i)
+    {
+        std::size_t lo = 0;
+        std::size_t hi = std::distance(seqs[i].first, seqs[i].second);
+        while (lo < hi)
+        {
+            std::size_t mid = lo + (hi - lo) / 2;
+            if(mergedRank(i, mid) < rank) { lo = mid + 1; }
+            else { hi = mid; }
+        }
+        ret[i] = lo;
+    }
+    return ret;
+}
+
+/** Sorts [first, last) in parallel with a multiway mergesort. The result
+    is stable if sortChunk is.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param less - the ordering to sort by
+    @param threads - the number of chunks, and of threads to use
+    @param sortChunk - called as sortChunk(begin, end) to sort one chunk
+    @param forEach - called as forEach(count, f), it must call f(i) for
+        every i in [0, count) in parallel and return once all have finished
+*/
+template<std::random_access_iterator Iter, typename Compare, typename SortChunk, typename ForEach>
+void
+multiwayMergeSort (Iter first, Iter last, Compare less, std::size_t threads, const SortChunk &sortChunk,
+    const ForEach &forEach)
+{
+    using T = std::iter_value_t<Iter>;
+
+    std::size_t size = std::distance(first, last);
+    std::size_t chunks = std::max<std::size_t>(1, std::min(threads, size));
+    if(chunks == 1)
+    {
+        sortChunk(first, last);
+        return;
+    }
+
+    std::vector<std::pair<Iter, Iter>> seqs(chunks);
+    for(std::size_t i = 0; i < chunks; ++i)
+    {
+        seqs[i] = {first + i * size / chunks, first + (i + 1) * size / chunks};
+    }
+    forEach(chunks, [&] (std::size_t i) { sortChunk(seqs[i].first, seqs[i].second); });
+
+    //thread t writes ranks [t * size / chunks, (t + 1) * size / chunks) of
+    //the output, from the part of each chunk between the two splits
+    std::vector<T> buffer(size);
+    forEach(chunks, [&] (std::size_t t) {
+        std::size_t begin = t * size / chunks;
+        std::size_t end = (t + 1) * size / chunks;
+        auto lo = multiSequenceSplit(seqs, begin, less);
+        auto hi = multiSequenceSplit(seqs, end, less);
+
+        std::vector<std::pair<Iter, Iter>> pieces(chunks);
+        for(std::size_t i = 0; i < chunks; ++i)
+        {
+            pieces[i] = {seqs[i].first + lo[i], seqs[i].first + hi[i]};
+        }
+        LoserTree<Iter, Compare> tree(pieces, less);
+        for(std::size_t out = begin; out < end; ++out) { tree.pop(buffer.begin() + out); }
+    });
+
+    forEach(chunks, [&] (std::size_t t) {
+        std::move(buffer.begin() + t * size / chunks, buffer.begin() + (t + 1) * size / chunks, first + t * size / chunks);
+    });
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
@@ -0,0 +1,189 @@
+/*
+  Filename   : Ordering.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: The comparison used by the sorts. A comparator and a
+               projection (as in std::ranges::sort) are bundled into one
+               strict weak ordering on elements, which is what the kernels
+               are passed. Also holds the element types the benchmarks can
+               generate besides uint, and the arrangement of generated data
+               into sorted runs.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef ORDERING_H
+#define ORDERING_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <type_traits>
+
+/************************************************************/
+// Local includes
+
+#include "KeyNormalization.hpp"
+
+/************************************************************/
+// Using declarations
+
+/************************************************************/
+
+/** Orders elements by comparing their projections.
+
+    @param comp - the comparator applied to the projected values
+    @param proj - the projection applied to each element first
+*/
+template<typename Comp = std::ranges::less, typename Proj = std::identity>
+struct ProjectedLess
+{
+    [[no_unique_address]] Comp comp{};
+    [[no_unique_address]] Proj proj{};
+
+    template<typename A, typename B>
+    bool
+    operator() (const A &a, const B &b) const
+    {
+        return std::invoke(comp, std::invoke(proj, a), std::invoke(proj, b));
+    }
+};
+
+/** The ordering used when no comparator or projection is given. */
+using DefaultLess = ProjectedLess<>;
+
+/** True when Compare is the plain < on the elements themselves, which is
+    what the vectorized kernels assume.
+*/
+template<typename Compare>
+constexpr bool isDefaultLess = std::is_same_v<Compare, DefaultLess>;
+
+/** A 16 byte record sorted by its key, used to measure the cost of moving
+    a payload along with the key.
+*/
+struct Record
+{
+    std::uint64_t key{};
+    std::uint64_t payload{};
+};
+
+/** A record of Bytes bytes sorted by its key, for payloads too wide to be
+    worth moving on every swap.
+*/
+template<std::size_t Bytes>
+struct WideRecord
+{
+    static_assert(Bytes % 8 == 0 && Bytes > 8);
+    std::uint64_t key{};
+    std::array<std::uint64_t, Bytes / 8 - 1> payload{};
+};
+
+using Record32 = WideRecord<32>;
+using Record64 = WideRecord<64>;
+using Record256 = WideRecord<256>;
+
+/** True when T is one of the WideRecords. */
+template<typename T>
+constexpr bool isWideRecord = false;
+
+template<std::size_t Bytes>
+constexpr bool isWideRecord<WideRecord<Bytes>> = true;
+
+/** Makes a random element of type T.
+
+    @param gen - the 64-bit generator to draw from
+
+    @return - a uniformly random integer, a float or double in [-1, 1), a
+        string of random lowercase letters, or a record with a random key
+*/
+template<typename T>
+T
+randomElement (std::mt19937_64 &gen)
+{
+    if constexpr (std::is_same_v<T, Record>)
+    {
+        std::uint64_t key = gen();
+        return Record{key, ~key};
+    }
+    else if constexpr (isWideRecord<T>)
+    {
+        T ret;
+        ret.key = gen();
+        ret.payload.fill(~ret.key);
+        return ret;
+    }
+    else if constexpr (isFixedString<T>)
+    {
+        T ret;
+        for(unsigned char &c : ret.chars) { c = 'a' + gen() % 26; }
+        return ret;
+    }
+    else if constexpr (std::is_floating_point_v<T>)
+    {
+        //negative keys too, which the normalized sorts must put first
+        return std::uniform_real_distribution<T>(-1, 1)(gen);
+    }
+    else {
+        return static_cast<T>(gen());
+    }
+}
+
+/** Limits [first, last) to its first distinct elements, replacing every
+    later one with a copy of one of them picked at random, which is how
+    data with few distinct keys, such as status codes, looks to a sort.
+
+    @param first - the start of the generated data
+    @param last - the end (exclusive) of the generated data
+    @param distinct - the number of elements to keep, or 0 to leave the
+        data as it is
+*/
+template<std::random_access_iterator Iter>
+void
+limitDistinct (Iter first, Iter last, std::size_t distinct)
+{
+    std::size_t size = std::distance(first, last);
+    if(distinct == 0 || distinct >= size) { return; }
+
+    std::mt19937_64 gen{size};
+    for(std::size_t i = distinct; i < size; ++i) { first[i] = first[gen() % distinct]; }
+}
+
+/** Sorts [first, last) into runs of (nearly) equal length, alternately
+    ascending and descending, which is how partly ordered data such as
+    concatenated sorted files looks to a sort.
+
+    @param first - the start of the generated data
+    @param last - the end (exclusive) of the generated data
+    @param runs - the number of runs, or 0 to leave the data random
+    @param less - the ordering the data will be sorted by
+*/
+template<std::random_access_iterator Iter, typename Compare>
+void
+arrangeRuns (Iter first, Iter last, std::size_t runs, Compare less)
+{
+    if(runs == 0) { return; }
+
+    std::size_t size = std::distance(first, last);
+    for(std::size_t run = 0; run < runs; ++run)
+    {
+        Iter begin = first + run * size / runs;
+        Iter end = first + (run + 1) * size / runs;
+        std::sort(begin, end, less);
+        if(run % 2 == 1) { std::reverse(begin, end); }
+    }
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
@@ -0,0 +1,177 @@
+/*
+  Filename   : ParallelPartition.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: An in-place partition that every thread works on at once,
+               after Tsigas and Zhang. Each thread claims a block from the
+               left end and one from the right end with an atomic counter,
+               and swaps misplaced elements between them until one is clean,
+               then claims another. The few blocks left half done when the
+               counter runs out are gathered next to the split point and
+               partitioned by the calling thread. The parallel quicksorts
+               use it for ranges too big to partition on one core.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef PARALLEL_PARTITION_H
+#define PARALLEL_PARTITION_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+/************************************************************/
+// Local includes
+
+/************************************************************/
+// Using declarations
+
+//the size of a block in bytes. A thread claims one block per fetch-add, so
+//this trades contention on the counters against the size of the cleanup.
+const static std::size_t PARTITION_BLOCK_BYTES = 4096;
+
+/** The number of elements of type T in a block. */
+template<typename T>
+constexpr std::size_t partitionBlockSize = std::max<std::size_t>(1, PARTITION_BLOCK_BYTES / sizeof(T));
+
+/************************************************************/
+
+/** Reorders [first, last) such that the elements satisfying pred come
+    before the ones that do not, with every thread working at once.
+
+    NOTE: the threads claim the blocks as they go, so forEach may skip any
+    f(i) but f(0) that has not started by the time f(0) returns.
+
+    @param first - the start of the range to partition
+    @param last - one past the end of the range to partition
+    @param pred - the predicate to partition by
+    @param threads - the number of threads to partition with
+    @param forEach - called as forEach(count, f), it must call f(i) for
+        every i in [0, count) in parallel and return once all have finished
+
+    @return - the first element not satisfying pred
+*/
+template<std::random_access_iterator Iter, typename Predicate, typename ForEach>
+Iter
+parallelSplit (Iter first, Iter last, Predicate pred, std::size_t threads, const ForEach &forEach)
+{
+    const std::size_t B = partitionBlockSize<std::iter_value_t<Iter>>;
+    const std::size_t NONE = static_cast<std::size_t>(-1);
+
+    std::size_t size = std::distance(first, last);
+    std::size_t numBlocks = size / B;
+    if(threads < 2 || numBlocks < 2 * threads) { return std::partition(first, last, pred); }
+
+    //left block k is the k-th block from the start of the range, and right
+    //block k the k-th from its end. At most numBlocks are handed out, so the
+    //two sides never meet and the last partial block lies between them.
+    auto leftBlock = [&] (std::size_t k) { return first + k * B; };
+    auto rightBlock = [&] (std::size_t k) { return last - (k + 1) * B; };
+
+    std::atomic<std::size_t> claimed{0};
+    std::atomic<std::size_t> leftClaimed{0};
+    std::atomic<std::size_t> rightClaimed{0};
+    std::vector<std::size_t> unfinishedLeft(threads, NONE);
+    std::vector<std::size_t> unfinishedRight(threads, NONE);
+    forEach(threads, [&] (std::size_t i) {
+        auto claim = [&] (std::atomic<std::size_t> &side, std::size_t &block) {
+            if(claimed++ >= numBlocks) { return false; }
+            block = side++;
+            return true;
+        };
+
+        std::size_t leftK = 0;
+        std::size_t rightK = 0;
+        std::size_t l = 0;
+        std::size_t r = 0;
+        bool haveLeft = claim(leftClaimed, leftK);
+        bool haveRight = haveLeft && claim(rightClaimed, rightK);
+        while (haveLeft && haveRight)
+        {
+            Iter left = leftBlock(leftK);
+            Iter right = rightBlock(rightK);
+            while (l < B && pred(left[l])) { ++l; }
+            while (r < B && !pred(right[r])) { ++r; }
+            if(l == B)
+            {
+                haveLeft = claim(leftClaimed, leftK);
+                l = 0;
+            }
+            else if(r == B)
+            {
+                haveRight = claim(rightClaimed, rightK);
+                r = 0;
+            }
+            else {
+                std::iter_swap(left + l++, right + r++);
+            }
+        }
+        if(haveLeft) { unfinishedLeft[i] = leftK; }
+        if(haveRight) { unfinishedRight[i] = rightK; }
+    });
+
+    //swap the unfinished blocks of a side with clean ones until they are
+    //the count closest to the middle, returning how many there are
+    auto gather = [&] (std::vector<std::size_t> &unfinished, std::size_t count, const auto &blockAt) {
+        std::erase(unfinished, NONE);
+        std::sort(unfinished.begin(), unfinished.end());
+        std::size_t start = count - unfinished.size();
+        std::size_t slot = start;
+        for(std::size_t block : unfinished)
+        {
+            if(block >= start) { break; }
+            while (std::binary_search(unfinished.begin(), unfinished.end(), slot)) { ++slot; }
+            std::swap_ranges(blockAt(block), blockAt(block) + B, blockAt(slot++));
+        }
+        return unfinished.size();
+    };
+    std::size_t cleanLeft = leftClaimed - gather(unfinishedLeft, leftClaimed, leftBlock);
+    std::size_t cleanRight = rightClaimed - gather(unfinishedRight, rightClaimed, rightBlock);
+
+    //what is left is at most one block per thread per side, plus the
+    //partial block
+    return std::partition(first + cleanLeft * B, last - cleanRight * B, pred);
+}
+
+/** Partitions [begin, end) around pivot with every thread at once. The
+    elements less than pivot come first. Those equal to it are only split
+    off from the greater ones when nothing is less than pivot, which is
+    all the quicksort needs to make progress.
+
+    @param begin - the start of the range to partition
+    @param end - one past the end of the range to partition
+    @param pivot - the value to partition around, taken from the range
+    @param less - the ordering to partition by
+    @param threads - the number of threads to partition with
+    @param forEach - as for parallelSplit
+
+    @return - the iterators (lowPivot, hiPivot). [begin, lowPivot) is less
+        than pivot, [lowPivot, hiPivot) equal to it, and [hiPivot, end) not
+        less than it
+*/
+template<std::random_access_iterator Iter, typename Value, typename Compare, typename ForEach>
+std::pair<Iter, Iter>
+parallelPartition (Iter begin, Iter end, const Value &pivot, Compare less, std::size_t threads, const ForEach &forEach)
+{
+    Iter lowPivot = parallelSplit(begin, end, [&] (const auto &val) { return less(val, pivot); }, threads, forEach);
+    if(lowPivot != begin) { return {lowPivot, lowPivot}; }
+
+    //pivot is the minimum, so pull out the elements equal to it
+    Iter hiPivot = parallelSplit(begin, end, [&] (const auto &val) { return !less(pivot, val); }, threads, forEach);
+    return {lowPivot, hiPivot};
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
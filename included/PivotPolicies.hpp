@@ -0,0 +1,144 @@
+/*
+  Filename   : PivotPolicies.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: Pivot selection policies for the quicksorts. Each policy is a
+               function object that, given a range and the ordering it is
+               sorted by, returns the value the range should be partitioned
+               on. The value is always taken from
+               the range, which the partitions rely on to make progress.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef PIVOT_POLICIES_H
+#define PIVOT_POLICIES_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <vector>
+
+/************************************************************/
+// Local includes
+
+/************************************************************/
+// Using declarations
+
+/************************************************************/
+
+/** Returns the median of three values under less. */
+template<typename Value, typename Compare>
+Value
+medianOf3 (const Value &a, const Value &b, const Value &c, Compare less)
+{
+    if(less(a, b))
+    {
+        if(less(b, c)) { return b; }
+        return less(a, c) ? c : a;
+    }
+    if(less(a, c)) { return a; }
+    return less(b, c) ? c : b;
+}
+
+/** Uses the first element of the range. This is the original behavior, and
+    is quadratic on sorted and reverse-sorted input.
+*/
+struct FirstPivot
+{
+    template<std::random_access_iterator Iter, typename Compare>
+    std::iter_value_t<Iter>
+    operator() (Iter begin, Iter, Compare) const
+    {
+        return *begin;
+    }
+};
+
+/** Uses the median of the first, middle and last elements. */
+struct MedianOf3Pivot
+{
+    template<std::random_access_iterator Iter, typename Compare>
+    std::iter_value_t<Iter>
+    operator() (Iter begin, Iter end, Compare less) const
+    {
+        auto size = std::distance(begin, end);
+        return medianOf3(*begin, begin[size / 2], *std::prev(end), less);
+    }
+};
+
+/** Uses Tukey's ninther: the median of the medians of three evenly spaced
+    triples. Ranges too small to hold three triples use median-of-3.
+*/
+struct NintherPivot
+{
+    template<std::random_access_iterator Iter, typename Compare>
+    std::iter_value_t<Iter>
+    operator() (Iter begin, Iter end, Compare less) const
+    {
+        auto size = std::distance(begin, end);
+        if(size < 128) { return MedianOf3Pivot{}(begin, end, less); }
+
+        auto step = size / 8;
+        auto mid = size / 2;
+        return medianOf3(
+            medianOf3(begin[0], begin[step], begin[2 * step], less),
+            medianOf3(begin[mid - step], begin[mid], begin[mid + step], less),
+            medianOf3(begin[size - 1 - 2 * step], begin[size - 1 - step], begin[size - 1], less),
+            less);
+    }
+};
+
+/** Uses a uniformly random element. Each thread has its own generator, which
+    is seeded the same way every run so that results are repeatable.
+*/
+struct RandomPivot
+{
+    template<std::random_access_iterator Iter, typename Compare>
+    std::iter_value_t<Iter>
+    operator() (Iter begin, Iter end, Compare) const
+    {
+        thread_local std::minstd_rand gen{476};
+        std::uniform_int_distribution<std::iter_difference_t<Iter>> dist(0, std::distance(begin, end) - 1);
+        return begin[dist(gen)];
+    }
+};
+
+/** Uses the median of sampleSize evenly spaced elements. Ranges smaller than
+    eight samples per element use median-of-3, as the copy would cost more
+    than a slightly worse pivot.
+*/
+struct SampleMedianPivot
+{
+    unsigned sampleSize{64};
+
+    template<std::random_access_iterator Iter, typename Compare>
+    std::iter_value_t<Iter>
+    operator() (Iter begin, Iter end, Compare less) const
+    {
+        auto size = std::distance(begin, end);
+        if(sampleSize < 3 || size < 8 * static_cast<decltype(size)>(sampleSize))
+        {
+            return MedianOf3Pivot{}(begin, end, less);
+        }
+
+        auto step = size / sampleSize;
+        std::vector<std::iter_value_t<Iter>> sample(sampleSize);
+        for(unsigned i = 0; i < sampleSize; ++i)
+        {
+            sample[i] = begin[i * step];
+        }
+        std::nth_element(sample.begin(), sample.begin() + sampleSize / 2, sample.end(), less);
+        return sample[sampleSize / 2];
+    }
+};
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
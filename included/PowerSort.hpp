@@ -0,0 +1,343 @@
+/*
+  Filename   : PowerSort.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: An adaptive, stable mergesort after Munro and Wild's
+               Powersort. The range is scanned for natural runs, ascending
+               or strictly descending (which are reversed), and runs shorter
+               than the cutoff are extended with insertion sort. Each pair
+               of neighbouring runs is given the depth its boundary would
+               have in a perfectly balanced merge tree over the whole range,
+               and runs are merged in that order, which is within a constant
+               of the optimal merge cost for the run lengths. Merges gallop
+               once one side keeps winning, so long stretches of one run are
+               moved with a binary search rather than one comparison each.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef POWER_SORT_H
+#define POWER_SORT_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+/************************************************************/
+// Local includes
+
+#include "FinishingPass.hpp"
+
+/************************************************************/
+// Using declarations
+
+//the number of elements one side must win in a row before the merge
+//switches to galloping, as in Timsort
+const static std::size_t POWERSORT_MIN_GALLOP = 7;
+
+//inputs whose natural runs are shorter than this on average have too
+//little order for merging to beat quicksort
+const static std::size_t POWERSORT_MIN_AVERAGE_RUN = 48;
+
+/************************************************************/
+
+/** Finds the first element in [first, last) that does not satisfy pred,
+    which must be true for some prefix of the range and false after. The
+    range is probed at distances 1, 3, 7, ... before a binary search, so
+    this costs O(log k) when k elements satisfy pred.
+
+    @param first - the start of the range to search
+    @param last - the end (exclusive) of the range to search
+    @param pred - the predicate, partitioning the range
+
+    @return - the first element not satisfying pred, or last
+*/
+template<std::random_access_iterator Iter, typename Predicate>
+Iter
+gallop (Iter first, Iter last, Predicate pred)
+{
+    std::size_t size = std::distance(first, last);
+    std::size_t lo = 0;
+    std::size_t hi = 1;
+    while (hi < size && pred(first[hi - 1]))
+    {
+        lo = hi;
+        hi = 2 * hi + 1;
+    }
+    hi = std::min(hi, size);
+    return std::partition_point(first + lo, first + hi, pred);
+}
+
+/** Merges a buffered run into the run after it, writing from the front.
+    On equal elements the buffered run goes first, so the buffered run must
+    be the one that came first in the original order.
+
+    NOTE: out must not be past in, and the gap between them must be the
+    size of the buffered run
+
+    @param buf - the start of the buffered run
+    @param bufLast - the end (exclusive) of the buffered run
+    @param in - the start of the run still in place
+    @param inLast - the end (exclusive) of the run still in place
+    @param out - where the merged output starts
+    @param less - the ordering to merge by
+*/
+template<typename BufIter, typename Iter, typename Compare>
+void
+gallopingMerge (BufIter buf, BufIter bufLast, Iter in, Iter inLast, Iter out, Compare less)
+{
+    std::size_t bufWins = 0;
+    std::size_t inWins = 0;
+    while (buf != bufLast && in != inLast)
+    {
+        if(bufWins >= POWERSORT_MIN_GALLOP)
+        {
+            //move every buffered element not greater than *in at once
+            BufIter stop = gallop(buf, bufLast, [&] (const auto &val) { return !less(*in, val); });
+            out = std::move(buf, stop, out);
+            buf = stop;
+            bufWins = 0;
+        }
+        else if(inWins >= POWERSORT_MIN_GALLOP)
+        {
+            //and every element in place less than *buf
+            Iter stop = gallop(in, inLast, [&] (const auto &val) { return less(val, *buf); });
+            out = std::move(in, stop, out);
+            in = stop;
+            inWins = 0;
+        }
+        else if(less(*in, *buf))
+        {
+            *out++ = std::move(*in++);
+            ++inWins;
+            bufWins = 0;
+        }
+        else {
+            *out++ = std::move(*buf++);
+            ++bufWins;
+            inWins = 0;
+        }
+    }
+    //what is left in place already is
+    std::move(buf, bufLast, out);
+}
+
+/** Merges the neighbouring sorted runs [first, mid) and [mid, last),
+    stably. Elements already in their final place at either end are
+    skipped, and the shorter of what remains is moved to the buffer.
+
+    @param first - the start of the first run
+    @param mid - the end of the first run, and the start of the second
+    @param last - the end (exclusive) of the second run
+    @param buffer - space for at least half of [first, last)
+    @param less - the ordering to merge by
+*/
+template<std::random_access_iterator Iter, typename T, typename Compare>
+void
+mergeRuns (Iter first, Iter mid, Iter last, std::vector<T> &buffer, Compare less)
+{
+    //the first run's elements not greater than the second's first stay put,
+    //as do the second run's elements not less than the first's last
+    first = gallop(first, mid, [&] (const auto &val) { return !less(*mid, val); });
+    if(first == mid) { return; }
+    last = gallop(mid, last, [&] (const auto &val) { return less(val, *std::prev(mid)); });
+
+    std::size_t leftSize = std::distance(first, mid);
+    std::size_t rightSize = std::distance(mid, last);
+    if(leftSize <= rightSize)
+    {
+        std::move(first, mid, buffer.begin());
+        gallopingMerge(buffer.begin(), buffer.begin() + leftSize, mid, last, first, less);
+    }
+    else {
+        //merge from the back, which is a merge from the front of the
+        //reversed runs under the reversed ordering. The second run now comes
+        //first, so ties still keep their order.
+        std::move(mid, last, buffer.begin());
+        auto greater = [&] (const auto &a, const auto &b) { return less(b, a); };
+        gallopingMerge(std::make_reverse_iterator(buffer.begin() + rightSize), std::make_reverse_iterator(buffer.begin()),
+            std::make_reverse_iterator(mid), std::make_reverse_iterator(first), std::make_reverse_iterator(last), greater);
+    }
+}
+
+/** Computes the power of the boundary between two neighbouring runs, which
+    is the depth of the first level of a balanced binary tree over [0, n)
+    at which the runs' midpoints fall in different halves.
+
+    @param start - the offset of the first run from the start of the range
+    @param leftSize - the length of the first run
+    @param rightSize - the length of the second run
+    @param size - the length of the whole range
+
+    @return - the boundary's power, at least 1
+*/
+inline unsigned
+runPower (std::size_t start, std::size_t leftSize, std::size_t rightSize, std::size_t size)
+{
+    //twice the midpoints, read a bit at a time as fractions of 2 * size
+    std::size_t a = 2 * start + leftSize;
+    std::size_t b = a + leftSize + rightSize;
+    unsigned power = 0;
+    while (true)
+    {
+        ++power;
+        if(a >= size)
+        {
+            a -= size;
+            b -= size;
+        }
+        else if(b >= size) { break; }
+        a <<= 1;
+        b <<= 1;
+    }
+    return power;
+}
+
+/** Finds the natural run starting at first, reversing it if it is
+    descending. Only strictly descending runs are reversed, which keeps
+    the sort stable.
+
+    @param first - the start of the run
+    @param last - the end (exclusive) of the range
+    @param less - the ordering to sort by
+
+    @return - the end of the run
+*/
+template<std::random_access_iterator Iter, typename Compare>
+Iter
+findRun (Iter first, Iter last, Compare less)
+{
+    if(std::distance(first, last) < 2) { return last; }
+
+    Iter end = std::next(first);
+    if(less(*end, *first))
+    {
+        while (std::next(end) != last && less(*std::next(end), *end)) { ++end; }
+        std::reverse(first, ++end);
+    }
+    else {
+        while (std::next(end) != last && !less(*std::next(end), *end)) { ++end; }
+        ++end;
+    }
+    return end;
+}
+
+/** Counts the natural runs of [first, last), without changing it. Stops
+    counting once limit is passed.
+
+    @param first - the start of the range
+    @param last - the end (exclusive) of the range
+    @param less - the ordering to sort by
+    @param limit - the count after which to stop
+
+    @return - the number of runs, or limit + 1 if there are more
+*/
+template<std::random_access_iterator Iter, typename Compare>
+std::size_t
+countRuns (Iter first, Iter last, Compare less, std::size_t limit)
+{
+    std::size_t runs = 0;
+    while (first != last && runs <= limit)
+    {
+        ++runs;
+        Iter end = std::next(first);
+        if(end != last && less(*end, *first))
+        {
+            while (end != last && less(*end, *std::prev(end))) { ++end; }
+        }
+        else {
+            while (end != last && !less(*end, *std::prev(end))) { ++end; }
+        }
+        first = end;
+    }
+    return runs;
+}
+
+/** Sorts [first, last) by merging its natural runs, if there are few
+    enough of them, and with fallback otherwise.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param cutoff - runs shorter than this are extended to it (or the end of
+        the range) with insertion sort
+    @param less - the ordering to sort by
+    @param fallback - called as fallback(first, last) to sort a range with
+        too little order
+
+    @return - the number of runs merged, or 0 if fallback was used
+*/
+template<std::random_access_iterator Iter, typename Compare, typename Fallback>
+std::size_t
+powerSort (Iter first, Iter last, std::size_t cutoff, Compare less, const Fallback &fallback)
+{
+    using T = std::iter_value_t<Iter>;
+
+    std::size_t size = std::distance(first, last);
+    if(countRuns(first, last, less, size / POWERSORT_MIN_AVERAGE_RUN) > size / POWERSORT_MIN_AVERAGE_RUN)
+    {
+        fallback(first, last);
+        return 0;
+    }
+
+    struct Run
+    {
+        Iter begin;
+        Iter end;
+        //the power of the boundary after this run
+        unsigned power;
+    };
+    std::vector<Run> stack;
+    std::vector<T> buffer(size / 2 + 1);
+    std::size_t merged = 0;
+
+    auto nextRun = [&] (Iter begin) {
+        Iter end = findRun(begin, last, less);
+        if(static_cast<std::size_t>(std::distance(begin, end)) < cutoff)
+        {
+            Iter extended = begin + std::min<std::size_t>(cutoff, std::distance(begin, last));
+            insertionPass(begin, extended, less);
+            end = extended;
+        }
+        ++merged;
+        return end;
+    };
+
+    Iter begin = first;
+    Iter end = nextRun(begin);
+    while (end != last)
+    {
+        Iter nextEnd = nextRun(end);
+        unsigned power = runPower(std::distance(first, begin), std::distance(begin, end), std::distance(end, nextEnd), size);
+
+        //merge the runs whose boundaries are deeper than this one's
+        while (!stack.empty() && stack.back().power > power)
+        {
+            mergeRuns(stack.back().begin, begin, end, buffer, less);
+            begin = stack.back().begin;
+            stack.pop_back();
+        }
+        stack.push_back({begin, end, power});
+        begin = end;
+        end = nextEnd;
+    }
+    while (!stack.empty())
+    {
+        mergeRuns(stack.back().begin, begin, end, buffer, less);
+        begin = stack.back().begin;
+        stack.pop_back();
+    }
+    return merged;
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
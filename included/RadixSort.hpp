@@ -0,0 +1,245 @@
+/*
+  Filename   : RadixSort.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: Least significant digit radix sort for unsigned integer keys.
+               Each pass scatters the elements by one digit into a second
+               buffer of the same size, and the two buffers swap roles
+               between passes (ping-pong). The parallel version splits the
+               array into one chunk per thread, and each thread counts and
+               scatters its own chunk with its own histogram.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/************************************************************/
+// Local includes
+
+/************************************************************/
+// Using declarations
+
+//how many elements ahead the scatter loops prefetch the bucket slot for
+const static std::size_t PREFETCH_DISTANCE = 16;
+
+/************************************************************/
+
+/** The unsigned key type keyOf returns for elements of type T. */
+template<typename T, typename KeyOf>
+using RadixKey = std::make_unsigned_t<std::remove_cvref_t<std::invoke_result_t<KeyOf, const T &>>>;
+
+/** Computes the number of digitBits wide digits in a Key. */
+template<typename Key>
+constexpr unsigned
+digitCount (unsigned digitBits)
+{
+    return (8 * sizeof(Key) + digitBits - 1) / digitBits;
+}
+
+/** Extracts digit d of key. */
+template<unsigned DigitBits, typename Key>
+inline std::size_t
+digitOf (Key key, unsigned d)
+{
+    return static_cast<std::size_t>(key >> (d * DigitBits)) & ((std::size_t{1} << DigitBits) - 1);
+}
+
+/** Computes the heap memory lsdRadixSort uses besides the array itself.
+
+    @param size - the number of elements to be sorted
+    @param chunks - the number of per-thread histograms, 1 for the serial sort
+
+    @return - the size of the buffer and histograms, in bytes
+*/
+template<typename T, typename Key, unsigned DigitBits>
+std::size_t
+radixExtraBytes (std::size_t size, std::size_t chunks)
+{
+    const std::size_t RADIX = std::size_t{1} << DigitBits;
+    //the parallel sort uses at most one chunk per RADIX elements
+    chunks = std::max<std::size_t>(1, std::min(chunks, size / RADIX));
+    if(chunks == 1)
+    {
+        return size * sizeof(T) + digitCount<Key>(DigitBits) * RADIX * sizeof(std::size_t);
+    }
+    return size * sizeof(T) + 2 * chunks * RADIX * sizeof(std::size_t);
+}
+
+/** Moves every element of [src, src + size) to dst, ordered by digit d.
+    The scatter is stable, so earlier passes stay in order within a bucket.
+
+    @param src - the elements to scatter
+    @param dst - where to scatter them
+    @param size - the number of elements
+    @param offsets - the position in dst of the next element of each bucket
+    @param keyOf - extracts the unsigned key of an element
+    @param d - the digit to scatter by
+*/
+template<unsigned DigitBits, std::random_access_iterator Iter, typename KeyOf>
+void
+scatterByDigit (Iter src, Iter dst, std::size_t size, std::size_t* offsets, KeyOf keyOf, unsigned d)
+{
+    for(std::size_t i = 0; i < size; ++i)
+    {
+        //the bucket slots are scattered all over dst, so ask for the one
+        //that will be written a few iterations from now
+        if(i + PREFETCH_DISTANCE < size)
+        {
+            std::size_t ahead = digitOf<DigitBits>(std::invoke(keyOf, src[i + PREFETCH_DISTANCE]), d);
+            __builtin_prefetch(std::to_address(dst + offsets[ahead]), 1);
+        }
+        std::size_t digit = digitOf<DigitBits>(std::invoke(keyOf, src[i]), d);
+        dst[offsets[digit]++] = std::move(src[i]);
+    }
+}
+
+/** Sorts [first, last) by the unsigned key keyOf returns, one DigitBits
+    wide digit at a time from the least significant up. The histograms of
+    every digit are built in a single pass up front, and digits that are
+    the same for every element are skipped.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param buffer - the start of a range at least as long as [first, last)
+    @param keyOf - extracts the unsigned key of an element
+*/
+template<unsigned DigitBits, std::random_access_iterator Iter, typename KeyOf>
+void
+lsdRadixSort (Iter first, Iter last, Iter buffer, KeyOf keyOf)
+{
+    using Key = RadixKey<std::iter_value_t<Iter>, KeyOf>;
+    const std::size_t RADIX = std::size_t{1} << DigitBits;
+    const unsigned DIGITS = digitCount<Key>(DigitBits);
+
+    std::size_t size = std::distance(first, last);
+    if(size < 2) { return; }
+
+    std::vector<std::size_t> counts(DIGITS * RADIX);
+    for(Iter cur = first; cur != last; ++cur)
+    {
+        Key key = std::invoke(keyOf, *cur);
+        for(unsigned d = 0; d < DIGITS; ++d)
+        {
+            ++counts[d * RADIX + digitOf<DigitBits>(key, d)];
+        }
+    }
+
+    Iter src = first;
+    Iter dst = buffer;
+    for(unsigned d = 0; d < DIGITS; ++d)
+    {
+        std::size_t* offsets = counts.data() + d * RADIX;
+        //every element has the same digit, so this pass would not move anything
+        if(offsets[digitOf<DigitBits>(std::invoke(keyOf, *src), d)] == size) { continue; }
+
+        std::size_t sum = 0;
+        for(std::size_t b = 0; b < RADIX; ++b)
+        {
+            sum += std::exchange(offsets[b], sum);
+        }
+        scatterByDigit<DigitBits>(src, dst, size, offsets, keyOf, d);
+        std::swap(src, dst);
+    }
+
+    if(src != first) { std::move(src, src + size, first); }
+}
+
+/** The parallel version of lsdRadixSort. Every pass counts each chunk into
+    its own histogram, turns the histograms into per-chunk offsets (chunk i
+    writes each bucket after chunks 0 to i - 1), then scatters each chunk.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param buffer - the start of a range at least as long as [first, last)
+    @param keyOf - extracts the unsigned key of an element
+    @param chunks - the number of chunks (and histograms) to use
+    @param forEach - called as forEach(count, f), it must call f(i) for
+        every i in [0, count) in parallel and return once all have finished
+*/
+template<unsigned DigitBits, std::random_access_iterator Iter, typename KeyOf, typename ForEach>
+void
+lsdRadixSort (Iter first, Iter last, Iter buffer, KeyOf keyOf, std::size_t chunks, const ForEach &forEach)
+{
+    using Key = RadixKey<std::iter_value_t<Iter>, KeyOf>;
+    const std::size_t RADIX = std::size_t{1} << DigitBits;
+    const unsigned DIGITS = digitCount<Key>(DigitBits);
+
+    std::size_t size = std::distance(first, last);
+    chunks = std::max<std::size_t>(1, std::min(chunks, size / RADIX));
+    if(chunks == 1)
+    {
+        lsdRadixSort<DigitBits>(first, last, buffer, keyOf);
+        return;
+    }
+    std::size_t chunkSize = (size + chunks - 1) / chunks;
+
+    std::vector<std::size_t> counts(chunks * RADIX);
+    std::vector<std::size_t> offsets(chunks * RADIX);
+    Iter src = first;
+    Iter dst = buffer;
+    for(unsigned d = 0; d < DIGITS; ++d)
+    {
+        forEach(chunks, [&, d] (std::size_t i) {
+            std::size_t* hist = counts.data() + i * RADIX;
+            std::fill(hist, hist + RADIX, 0);
+            std::size_t start = std::min(i * chunkSize, size);
+            std::size_t stop = std::min(start + chunkSize, size);
+            for(std::size_t j = start; j < stop; ++j)
+            {
+                ++hist[digitOf<DigitBits>(std::invoke(keyOf, src[j]), d)];
+            }
+        });
+
+        std::size_t sum = 0;
+        bool trivial = false;
+        for(std::size_t b = 0; b < RADIX; ++b)
+        {
+            std::size_t bucketStart = sum;
+            for(std::size_t i = 0; i < chunks; ++i)
+            {
+                offsets[i * RADIX + b] = sum;
+                sum += counts[i * RADIX + b];
+            }
+            trivial |= sum - bucketStart == size;
+        }
+        //every element has the same digit, so this pass would not move anything
+        if(trivial) { continue; }
+
+        forEach(chunks, [&, d] (std::size_t i) {
+            std::size_t start = std::min(i * chunkSize, size);
+            std::size_t stop = std::min(start + chunkSize, size);
+            scatterByDigit<DigitBits>(src + start, dst, stop - start, offsets.data() + i * RADIX, keyOf, d);
+        });
+        std::swap(src, dst);
+    }
+
+    if(src != first)
+    {
+        forEach(chunks, [&] (std::size_t i) {
+            std::size_t start = std::min(i * chunkSize, size);
+            std::size_t stop = std::min(start + chunkSize, size);
+            std::move(src + start, src + stop, first + start);
+        });
+    }
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
@@ -0,0 +1,309 @@
+/*
+  Filename   : SampleSort.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: In-place super scalar samplesort, in the style of IPS4o. Up to
+               255 splitters are picked from a random sample and stored as
+               an implicit binary search tree, so an element finds its bucket
+               with one comparison per level and no branches. Ranges larger
+               than a thread's share of the array are distributed by every
+               thread with blockDistribute, and the rest are sorted by one
+               thread each. When the sample has repeated splitters, elements
+               equal to a splitter get a bucket of their own that is never
+               sorted again, so many duplicates cannot stall the recursion.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef SAMPLE_SORT_H
+#define SAMPLE_SORT_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <utility>
+#include <vector>
+
+/************************************************************/
+// Local includes
+
+#include "BlockDistribution.hpp"
+#include "FinishingPass.hpp"
+
+/************************************************************/
+// Using declarations
+
+//at most 2^8 buckets per level, plus as many equality buckets
+const static unsigned SAMPLE_MAX_LOG_BUCKETS = 8;
+const static std::size_t SAMPLE_MAX_BUCKETS = std::size_t{2} << SAMPLE_MAX_LOG_BUCKETS;
+
+//the smallest average bucket size to aim for. Ranges of up to twice this
+//size (or the cutoff, if larger) are insertion sorted.
+const static std::size_t SAMPLE_BASE_CASE = 16;
+
+//a single thread only distributes in blocks once the range is this many
+//times the size of its buffers
+const static std::size_t SAMPLE_BLOCK_FACTOR = 4;
+
+/** The smallest range a single thread distributes in blocks. */
+template<typename T>
+constexpr std::size_t sampleBlockThreshold = SAMPLE_BLOCK_FACTOR * SAMPLE_MAX_BUCKETS * distributionBlockSize<T>;
+
+/** The classifier of one distribution step. */
+template<typename T, typename Compare>
+struct SplitterTree
+{
+    //the splitters as a complete binary search tree, root at index 1 and
+    //the children of node i at 2i and 2i + 1
+    std::vector<T> tree;
+    //the same splitters in order
+    std::vector<T> sorted;
+    unsigned logBuckets{1};
+    //whether elements equal to a splitter go to a bucket of their own
+    bool equalBuckets{false};
+    Compare less;
+
+    std::size_t
+    numBuckets () const
+    {
+        return (std::size_t{1} << logBuckets) * (equalBuckets ? 2 : 1);
+    }
+
+    /** Returns the bucket of val. Bucket b holds the elements greater than
+        splitter b - 1 and not greater than splitter b. With equality
+        buckets, those become buckets 2b and 2b + 1, the odd one holding the
+        elements equal to splitter b.
+    */
+    std::size_t
+    operator() (const T &val) const
+    {
+        //a fixed depth lets the descent unroll, so the descents of
+        //consecutive elements overlap
+        switch(logBuckets)
+        {
+            case 1: return classify<1>(val);
+            case 2: return classify<2>(val);
+            case 3: return classify<3>(val);
+            case 4: return classify<4>(val);
+            case 5: return classify<5>(val);
+            case 6: return classify<6>(val);
+            case 7: return classify<7>(val);
+            default: return classify<8>(val);
+        }
+    }
+
+    template<unsigned LogBuckets>
+    std::size_t
+    classify (const T &val) const
+    {
+        //go right exactly when the splitter is less than val. The result of
+        //the comparison is added to the index rather than branched on.
+        std::size_t node = 1;
+        for(unsigned level = 0; level < LogBuckets; ++level)
+        {
+            node = 2 * node + less(tree[node], val);
+        }
+        std::size_t bucket = node - (std::size_t{1} << LogBuckets);
+        if(!equalBuckets) { return bucket; }
+        return 2 * bucket + (bucket < sorted.size() && !less(val, sorted[bucket]));
+    }
+};
+
+/************************************************************/
+
+/** Computes an upper bound on the heap memory sampleSort uses besides the
+    range, which is the distribution buffers.
+
+    @param size - the number of elements to be sorted
+    @param threads - the number of threads sorting
+
+    @return - the size of the buffers, in bytes
+*/
+template<typename T>
+std::size_t
+sampleSortExtraBytes (std::size_t size, std::size_t threads)
+{
+    //every thread at once distributes a big range, or one of its own
+    std::size_t together = threads > 1 ? distributionExtraBytes<T>(threads, SAMPLE_MAX_BUCKETS) : 0;
+    std::size_t alone = std::min(threads, size / sampleBlockThreshold<T>) * distributionExtraBytes<T>(1, SAMPLE_MAX_BUCKETS);
+    return std::max(together, alone);
+}
+
+/** Picks the splitters of [first, last) from a random sample and builds
+    their search tree. The sample is 0.2 log2(size) elements per bucket,
+    as in IPS4o, and sorted with std::sort as it is tiny next to the range.
+
+    NOTE: the range must be longer than baseCase
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param less - the ordering to sort by
+    @param baseCase - the smallest average bucket size to aim for
+
+    @return - the classifier for the range
+*/
+template<std::random_access_iterator Iter, typename Compare>
+SplitterTree<std::iter_value_t<Iter>, Compare>
+chooseSplitters (Iter first, Iter last, Compare less, std::size_t baseCase)
+{
+    using T = std::iter_value_t<Iter>;
+
+    std::size_t size = std::distance(first, last);
+    unsigned logBuckets = std::clamp<unsigned>(std::bit_width(size / baseCase) - 1, 1, SAMPLE_MAX_LOG_BUCKETS);
+    std::size_t numBuckets = std::size_t{1} << logBuckets;
+    std::size_t oversampling = std::max<std::size_t>(1, std::bit_width(size) / 5);
+    std::size_t sampleSize = std::min(size, oversampling * numBuckets);
+
+    //each thread has its own generator, as in RandomPivot
+    thread_local std::minstd_rand gen{476};
+    std::uniform_int_distribution<std::size_t> dist(0, size - 1);
+    std::vector<T> sample(sampleSize);
+    for(T &val : sample) { val = first[dist(gen)]; }
+    std::sort(sample.begin(), sample.end(), less);
+
+    SplitterTree<T, Compare> ret{.tree = {}, .sorted = {}, .less = less};
+    for(std::size_t j = 1; j < numBuckets; ++j)
+    {
+        const T &splitter = sample[j * sampleSize / numBuckets];
+        if(!ret.sorted.empty() && !less(ret.sorted.back(), splitter))
+        {
+            ret.equalBuckets = true;
+            continue;
+        }
+        ret.sorted.push_back(splitter);
+    }
+    //a lone splitter may be the maximum, which would leave every element in
+    //bucket 0. Taking out the elements equal to it always makes progress.
+    ret.equalBuckets |= ret.sorted.size() == 1;
+
+    //shrink the tree to the unique splitters, repeating the last one to
+    //fill it. The repeats only ever leave buckets empty.
+    ret.logBuckets = std::bit_width(ret.sorted.size());
+    ret.sorted.resize((std::size_t{1} << ret.logBuckets) - 1, ret.sorted.back());
+
+    //an in-order walk of the tree visits the splitters in order
+    ret.tree.resize(std::size_t{1} << ret.logBuckets);
+    std::size_t next = 0;
+    auto build = [&] (auto &self, std::size_t node) -> void {
+        if(node >= ret.tree.size()) { return; }
+        self(self, 2 * node);
+        ret.tree[node] = ret.sorted[next++];
+        self(self, 2 * node + 1);
+    };
+    build(build, 1);
+    return ret;
+}
+
+/** Sorts [first, last) on the calling thread. Ranges large enough to pay
+    for the buffers are distributed in blocks, and smaller ones by
+    following swap cycles.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param less - the ordering to sort by
+    @param cutoff - the size at or below which insertion sort is used
+*/
+template<std::random_access_iterator Iter, typename Compare>
+void
+sampleSort (Iter first, Iter last, Compare less, std::size_t cutoff)
+{
+    using T = std::iter_value_t<Iter>;
+
+    std::size_t size = std::distance(first, last);
+    std::size_t baseCase = std::max(cutoff, SAMPLE_BASE_CASE);
+    if(size <= 2 * baseCase)
+    {
+        insertionPass(first, last, less);
+        return;
+    }
+
+    auto classifier = chooseSplitters(first, last, less, baseCase);
+    std::size_t numBuckets = classifier.numBuckets();
+    std::vector<std::size_t> bounds;
+    if(size >= sampleBlockThreshold<T>)
+    {
+        bounds = blockDistribute(first, last, numBuckets, std::cref(classifier), 1, [] (std::size_t count, const auto &f) {
+            for(std::size_t i = 0; i < count; ++i) { f(i); }
+        });
+    }
+    else {
+        bounds = cycleDistribute(first, last, numBuckets, std::cref(classifier));
+    }
+
+    for(std::size_t b = 0; b < numBuckets; ++b)
+    {
+        //an equality bucket only holds copies of its splitter
+        if(classifier.equalBuckets && b % 2 == 1) { continue; }
+        sampleSort(first + bounds[b], first + bounds[b + 1], less, cutoff);
+    }
+}
+
+/** Sorts [first, last) in parallel and in place. Ranges larger than
+    size / threads are distributed by every thread, and smaller ones are
+    sorted by one thread each, largest first.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param less - the ordering to sort by
+    @param cutoff - the size at or below which insertion sort is used
+    @param threads - the number of threads to use
+    @param forEach - called as forEach(count, f), it must call f(i) for
+        every i in [0, count) in parallel and return once all have finished
+*/
+template<std::random_access_iterator Iter, typename Compare, typename ForEach>
+void
+sampleSort (Iter first, Iter last, Compare less, std::size_t cutoff, std::size_t threads, const ForEach &forEach)
+{
+    std::size_t size = std::distance(first, last);
+    std::size_t baseCase = std::max(cutoff, SAMPLE_BASE_CASE);
+    std::size_t bigSize = size / std::max<std::size_t>(1, threads);
+
+    std::vector<std::pair<Iter, Iter>> big;
+    std::vector<std::pair<Iter, Iter>> small;
+    if(threads > 1 && size > baseCase) { big.emplace_back(first, last); }
+    else { small.emplace_back(first, last); }
+
+    while (!big.empty())
+    {
+        auto [begin, end] = big.back();
+        big.pop_back();
+
+        auto classifier = chooseSplitters(begin, end, less, baseCase);
+        std::size_t numBuckets = classifier.numBuckets();
+        auto bounds = blockDistribute(begin, end, numBuckets, std::cref(classifier), threads, forEach);
+
+        for(std::size_t b = 0; b < numBuckets; ++b)
+        {
+            std::size_t bucketSize = bounds[b + 1] - bounds[b];
+            if(bucketSize < 2 || (classifier.equalBuckets && b % 2 == 1)) { continue; }
+            auto &tasks = bucketSize > bigSize && bucketSize > baseCase ? big : small;
+            tasks.emplace_back(begin + bounds[b], begin + bounds[b + 1]);
+        }
+    }
+
+    std::sort(small.begin(), small.end(), [] (const auto &a, const auto &b) {
+        return a.second - a.first > b.second - b.first;
+    });
+    std::atomic<std::size_t> next{0};
+    forEach(threads, [&] (std::size_t) {
+        for(std::size_t task = next++; task < small.size(); task = next++)
+        {
+            sampleSort(small[task].first, small[task].second, less, cutoff);
+        }
+    });
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
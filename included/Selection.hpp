@@ -0,0 +1,184 @@
+/*
+  Filename   : Selection.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: Selection built on the quicksort partitions, for when only
+               some ranks of the sorted order are needed. Quickselect keeps
+               only the side of each partition that holds the rank it is
+               after, partialSort selects the k-th smallest and sorts what
+               is before it, and multiSelect finds many ranks in one pass,
+               following each side of a partition only while it still
+               holds a rank. The partition is passed in, so the parallel
+               sorts can have every thread partition the large ranges, and
+               multiSelect can follow both sides at once.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef SELECTION_H
+#define SELECTION_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+/************************************************************/
+// Local includes
+
+#include "Introsort.hpp"
+#include "FinishingPass.hpp"
+
+/************************************************************/
+// Using declarations
+
+/************************************************************/
+
+/** Rearranges [first, last) such that nth holds the element that would be
+    there if the range were sorted, no element before it is greater, and no
+    element after it is less, like std::nth_element.
+
+    @param first - the start of the range
+    @param nth - the position to select
+    @param last - the end (exclusive) of the range
+    @param cutoff - the size at or below which the rest is insertion sorted
+    @param budget - the number of partitioning levels left before the rest
+        is heapsorted instead
+    @param less - the ordering to select by
+    @param split - called as split(first, last), it must 3-way partition
+        the range and return the bounds of the elements equal to the pivot
+*/
+template<std::random_access_iterator Iter, typename Compare, typename Split>
+void
+quickSelect (Iter first, Iter nth, Iter last, std::size_t cutoff, unsigned budget, Compare less, const Split &split)
+{
+    while (static_cast<std::size_t>(std::distance(first, last)) > cutoff)
+    {
+        if(budget == 0)
+        {
+            heapsortFallback(first, last, less);
+            return;
+        }
+        --budget;
+
+        auto [lowPivot, hiPivot] = split(first, last);
+        if(nth < lowPivot) { last = lowPivot; }
+        else if(nth >= hiPivot) { first = hiPivot; }
+        //nth is equal to the pivot, and so already in place
+        else { return; }
+    }
+    insertionPass(first, last, less);
+}
+
+/** Rearranges [first, last) such that [first, middle) holds its smallest
+    elements in sorted order, like std::partial_sort.
+
+    @param first - the start of the range
+    @param middle - the end (exclusive) of the part to sort
+    @param last - the end (exclusive) of the range
+    @param cutoff - the size at or below which ranges are insertion sorted
+    @param budget - the number of partitioning levels left before a range
+        is heapsorted instead
+    @param less - the ordering to sort by
+    @param split - called as split(first, last), as for quickSelect
+    @param sortRange - called as sortRange(first, middle) to sort the
+        smallest elements once they are selected
+*/
+template<std::random_access_iterator Iter, typename Compare, typename Split, typename SortRange>
+void
+partialSort (Iter first, Iter middle, Iter last, std::size_t cutoff, unsigned budget, Compare less, const Split &split,
+    const SortRange &sortRange)
+{
+    if(middle == first) { return; }
+    if(middle != last) { quickSelect(first, middle, last, cutoff, budget, less, split); }
+    sortRange(first, middle);
+}
+
+/** Puts every rank in ranks in place at once, as if quickSelect had been
+    called for each. Each partition only follows the sides that still hold
+    some rank, so ranks that are close together share their partitions.
+
+    @param first - the start of the range
+    @param last - the end (exclusive) of the range
+    @param rank - the first of the ranks in [first, last), in ascending
+        order
+    @param rankEnd - the end (exclusive) of those ranks
+    @param offset - the rank of first in the whole range
+    @param cutoff - the size at or below which ranges are insertion sorted
+    @param budget - the number of partitioning levels left before a range
+        is heapsorted instead
+    @param less - the ordering to select by
+    @param split - called as split(first, last), as for quickSelect
+    @param spawn - called as spawn(task) for the side of each partition
+        that is not followed on this thread. The caller must wait for every
+        task spawned before using the range, and split and spawn must
+        outlive them.
+*/
+template<std::random_access_iterator Iter, typename Compare, typename Split, typename Spawn>
+void
+multiSelect (Iter first, Iter last, const std::size_t* rank, const std::size_t* rankEnd, std::size_t offset,
+    std::size_t cutoff, unsigned budget, Compare less, const Split &split, const Spawn &spawn)
+{
+    while (rank != rankEnd)
+    {
+        if(static_cast<std::size_t>(std::distance(first, last)) <= cutoff)
+        {
+            insertionPass(first, last, less);
+            return;
+        }
+        if(budget == 0)
+        {
+            heapsortFallback(first, last, less);
+            return;
+        }
+        --budget;
+
+        auto [lowPivot, hiPivot] = split(first, last);
+        std::size_t lowRank = offset + std::distance(first, lowPivot);
+        std::size_t hiRank = offset + std::distance(first, hiPivot);
+        //the ranks in [lowRank, hiRank) are equal to the pivot, and done
+        const std::size_t* lowEnd = std::lower_bound(rank, rankEnd, lowRank);
+        const std::size_t* hiStart = std::lower_bound(lowEnd, rankEnd, hiRank);
+
+        if(rank != lowEnd)
+        {
+            spawn([=, &split, &spawn] {
+                multiSelect(first, lowPivot, rank, lowEnd, offset, cutoff, budget, less, split, spawn);
+            });
+        }
+        first = hiPivot;
+        rank = hiStart;
+        offset = hiRank;
+    }
+}
+
+/** Computes the ranks that cut a range into equal parts.
+
+    @param size - the number of elements in the range
+    @param parts - the number of parts
+
+    @return - the ascending, distinct ranks i * size / parts for 0 < i <
+        parts, leaving out any that are not in the range
+*/
+inline std::vector<std::size_t>
+quantileRanks (std::size_t size, std::size_t parts)
+{
+    std::vector<std::size_t> ret;
+    for(std::size_t i = 1; i < parts; ++i)
+    {
+        std::size_t rank = i * size / parts;
+        if(rank < size && (ret.empty() || ret.back() != rank)) { ret.push_back(rank); }
+    }
+    return ret;
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
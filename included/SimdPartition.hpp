@@ -0,0 +1,295 @@
+/*
+  Filename   : SimdPartition.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: A vectorized in-place partition for contiguous 32-bit unsigned
+               keys. AVX-512 or AVX2 is picked at runtime based on CPUID, and
+               the scalar block partition is used when neither is available,
+               the keys are not contiguous 32-bit unsigned integers, or they
+               are not ordered by plain <.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef SIMD_PARTITION_H
+#define SIMD_PARTITION_H
+
+/************************************************************/
+// System includes
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <immintrin.h>
+
+/************************************************************/
+// Local includes
+
+#include "BlockPartition.hpp"
+#include "Ordering.hpp"
+
+/************************************************************/
+// Using declarations
+
+/** The instruction sets the vectorized partition can run with. */
+enum class SimdLevel { Scalar, AVX2, AVX512 };
+
+/************************************************************/
+
+/** Checks (once) which vector instruction set this CPU and OS support.
+
+    @return - the widest supported level
+*/
+inline SimdLevel
+simdLevel ()
+{
+    static const SimdLevel level = [] {
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx512f")) { return SimdLevel::AVX512; }
+        if(__builtin_cpu_supports("avx2")) { return SimdLevel::AVX2; }
+        return SimdLevel::Scalar;
+    }();
+    return level;
+}
+
+/** Places the elements of a small buffer at the free slots left between
+    writeLeft and writeRight once the vector loop has finished.
+
+    @param buf - the elements that still need a place
+    @param count - the number of elements in @p buf
+    @param writeLeft - the next free slot on the left side
+    @param writeRight - one past the last free slot on the right side
+    @param pivot - the value to partition by
+
+    @return - the partition point
+*/
+template<bool OrEqual>
+inline std::uint32_t*
+finishPartition (const std::uint32_t* buf, std::size_t count, std::uint32_t* writeLeft,
+    std::uint32_t* writeRight, std::uint32_t pivot)
+{
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        bool left = OrEqual ? buf[i] <= pivot : buf[i] < pivot;
+        if(left) { *writeLeft++ = buf[i]; }
+        else { *--writeRight = buf[i]; }
+    }
+    return writeLeft;
+}
+
+/** Builds the lane permutations used by the AVX2 kernel. Entry m moves the
+    lanes whose bit is set in m to the front (in order) and the rest to the
+    back.
+*/
+inline const std::array<std::array<std::int32_t, 8>, 256> &
+avx2PermutationTable ()
+{
+    static const auto table = [] {
+        std::array<std::array<std::int32_t, 8>, 256> ret{};
+        for(int mask = 0; mask < 256; ++mask)
+        {
+            int next = 0;
+            for(int lane = 0; lane < 8; ++lane)
+            {
+                if(mask & (1 << lane)) { ret[mask][next++] = lane; }
+            }
+            for(int lane = 0; lane < 8; ++lane)
+            {
+                if(!(mask & (1 << lane))) { ret[mask][next++] = lane; }
+            }
+        }
+        return ret;
+    }();
+    return table;
+}
+
+/** Partitions [begin, end) such that every element less than (or, if
+    OrEqual, not greater than) pivot comes first, using AVX2.
+
+    The first and last vector are set aside so that there is always at least
+    one vector of free space on each side. Each step reads a vector from the
+    side with less free space, permutes the small elements to the front, and
+    writes the whole vector to both sides; the unused lanes land in free
+    space.
+
+    NOTE: requires at least 16 elements.
+
+    @return - the partition point
+*/
+template<bool OrEqual>
+__attribute__((target("avx2"))) inline std::uint32_t*
+avx2PartitionBy (std::uint32_t* begin, std::uint32_t* end, std::uint32_t pivot)
+{
+    const std::size_t V = 8;
+    const auto &perms = avx2PermutationTable();
+    //there is no unsigned compare in AVX2, flipping the sign bit makes the
+    //signed compare order values as unsigned
+    const __m256i sign = _mm256_set1_epi32(INT32_MIN);
+    const __m256i pv = _mm256_xor_si256(_mm256_set1_epi32(pivot), sign);
+
+    std::uint32_t buf[3 * V];
+    std::copy(begin, begin + V, buf);
+    std::copy(end - V, end, buf + V);
+
+    std::uint32_t* readLeft = begin + V;
+    std::uint32_t* readRight = end - V;
+    std::uint32_t* writeLeft = begin;
+    std::uint32_t* writeRight = end;
+
+    while (static_cast<std::size_t>(readRight - readLeft) >= V)
+    {
+        __m256i vals;
+        if(readLeft - writeLeft <= writeRight - readRight)
+        {
+            vals = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(readLeft));
+            readLeft += V;
+        }
+        else {
+            readRight -= V;
+            vals = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(readRight));
+        }
+
+        __m256i greater = _mm256_cmpgt_epi32(_mm256_xor_si256(vals, sign), pv);
+        __m256i small = OrEqual ? _mm256_xor_si256(greater, _mm256_set1_epi32(-1))
+                                : _mm256_cmpgt_epi32(pv, _mm256_xor_si256(vals, sign));
+        unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(small));
+        unsigned count = std::popcount(mask);
+
+        __m256i perm = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(perms[mask].data()));
+        vals = _mm256_permutevar8x32_epi32(vals, perm);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(writeLeft), vals);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(writeRight - V), vals);
+        writeLeft += count;
+        writeRight -= V - count;
+    }
+
+    std::size_t rest = readRight - readLeft;
+    std::copy(readLeft, readRight, buf + 2 * V);
+    return finishPartition<OrEqual>(buf, 2 * V + rest, writeLeft, writeRight, pivot);
+}
+
+/** The AVX-512 version of avx2PartitionBy. Compress-stores replace the
+    permutation table.
+
+    NOTE: requires at least 32 elements.
+
+    @return - the partition point
+*/
+template<bool OrEqual>
+__attribute__((target("avx512f"))) inline std::uint32_t*
+avx512PartitionBy (std::uint32_t* begin, std::uint32_t* end, std::uint32_t pivot)
+{
+    const std::size_t V = 16;
+    const __m512i pv = _mm512_set1_epi32(pivot);
+
+    std::uint32_t buf[3 * V];
+    std::copy(begin, begin + V, buf);
+    std::copy(end - V, end, buf + V);
+
+    std::uint32_t* readLeft = begin + V;
+    std::uint32_t* readRight = end - V;
+    std::uint32_t* writeLeft = begin;
+    std::uint32_t* writeRight = end;
+
+    while (static_cast<std::size_t>(readRight - readLeft) >= V)
+    {
+        __m512i vals;
+        if(readLeft - writeLeft <= writeRight - readRight)
+        {
+            vals = _mm512_loadu_si512(readLeft);
+            readLeft += V;
+        }
+        else {
+            readRight -= V;
+            vals = _mm512_loadu_si512(readRight);
+        }
+
+        __mmask16 small = OrEqual ? _mm512_cmple_epu32_mask(vals, pv)
+                                  : _mm512_cmplt_epu32_mask(vals, pv);
+        unsigned count = std::popcount(static_cast<unsigned>(small));
+
+        _mm512_mask_compressstoreu_epi32(writeLeft, small, vals);
+        writeLeft += count;
+        writeRight -= V - count;
+        _mm512_mask_compressstoreu_epi32(writeRight, static_cast<__mmask16>(~small), vals);
+    }
+
+    std::size_t rest = readRight - readLeft;
+    std::copy(readLeft, readRight, buf + 2 * V);
+    return finishPartition<OrEqual>(buf, 2 * V + rest, writeLeft, writeRight, pivot);
+}
+
+/** Partitions [begin, end) with the widest kernel this CPU supports.
+
+    @return - the partition point
+*/
+template<bool OrEqual>
+inline std::uint32_t*
+simdPartitionBy (std::uint32_t* begin, std::uint32_t* end, std::uint32_t pivot)
+{
+    std::size_t size = end - begin;
+    SimdLevel level = simdLevel();
+    if(level == SimdLevel::AVX512 && size >= 32)
+    {
+        return avx512PartitionBy<OrEqual>(begin, end, pivot);
+    }
+    if(level != SimdLevel::Scalar && size >= 16)
+    {
+        return avx2PartitionBy<OrEqual>(begin, end, pivot);
+    }
+    return blockPartitionBy(begin, end, [=] (std::uint32_t val) {
+        return OrEqual ? val <= pivot : val < pivot;
+    });
+}
+
+/** Partitions the range [begin, end) around pivot with the same contract
+    as blockPartition, vectorized when the range holds contiguous 32-bit
+    unsigned keys ordered by plain <. Any other range uses blockPartition.
+
+    @param begin - the start of the range to partition
+    @param end - one past the end of the range to partition
+    @param pivot - the value on which the range should be partitioned
+    @param less - the ordering to partition by
+
+    @return - a pair such that all elements to the left of pair.first
+            are less than pivot, all elements between pair.first and
+            pair.second are equal to pivot, and all elements after
+            pair.second are not less than the pivot.
+*/
+template<std::random_access_iterator Iter, typename Value, typename Compare>
+std::pair<Iter, Iter>
+simdPartition (Iter begin, Iter end, const Value &pivot, Compare less)
+{
+    if constexpr (std::contiguous_iterator<Iter> && isDefaultLess<Compare>
+        && std::is_same_v<std::iter_value_t<Iter>, std::uint32_t>)
+    {
+        if(std::distance(begin, end) <= 1) { return {begin, end}; }
+
+        std::uint32_t* first = std::to_address(begin);
+        std::uint32_t* last = std::to_address(end);
+
+        std::uint32_t* mid = simdPartitionBy<false>(first, last, pivot);
+        if(mid != first) { return {begin + (mid - first), begin + (mid - first)}; }
+
+        //nothing was less than the pivot, so peel off the elements equal to it
+        std::uint32_t* high = simdPartitionBy<true>(first, last, pivot);
+        return {begin, begin + (high - first)};
+    }
+    else {
+        return blockPartition(begin, end, pivot, less);
+    }
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
@@ -0,0 +1,184 @@
+/*
+  Filename   : SmallSort.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: A sorting network small-sort for up to 64 contiguous 32-bit
+               unsigned keys. The keys are padded to a power of two and
+               sorted with a bitonic network held in AVX2 registers, or with
+               the same network on scalars when AVX2 is not available. There
+               are no data-dependent branches in either version. Other key
+               types and orderings are left to the caller.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef SMALL_SORT_H
+#define SMALL_SORT_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+#include <immintrin.h>
+
+/************************************************************/
+// Local includes
+
+#include "Ordering.hpp"
+#include "SimdPartition.hpp"
+
+/************************************************************/
+// Using declarations
+
+//the largest range the network can sort
+const static std::size_t NETWORK_MAX = 64;
+
+/************************************************************/
+
+/** Runs a bitonic sorting network over Regs AVX2 registers (8 keys each)
+    stored in buf. Compare-exchanges between registers are vertical min/max,
+    and those within a register pair each lane with a permuted copy.
+
+    @param buf - the keys to sort, padded to Regs * 8
+*/
+template<int Regs>
+__attribute__((target("avx2"))) inline void
+avx2BitonicSort (std::uint32_t* buf)
+{
+    const int N = Regs * 8;
+    __m256i v[Regs];
+    for(int r = 0; r < Regs; ++r)
+    {
+        v[r] = _mm256_load_si256(reinterpret_cast<const __m256i*>(buf + 8 * r));
+    }
+
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i zero = _mm256_setzero_si256();
+
+    for(int k = 2; k <= N; k <<= 1)
+    {
+        for(int j = k >> 1; j > 0; j >>= 1)
+        {
+            if(j >= 8)
+            {
+                for(int r = 0; r < Regs; ++r)
+                {
+                    int other = r ^ (j / 8);
+                    if(other < r) { continue; }
+                    __m256i lo = _mm256_min_epu32(v[r], v[other]);
+                    __m256i hi = _mm256_max_epu32(v[r], v[other]);
+                    bool ascending = ((8 * r) & k) == 0;
+                    v[r] = ascending ? lo : hi;
+                    v[other] = ascending ? hi : lo;
+                }
+                continue;
+            }
+
+            const __m256i jv = _mm256_set1_epi32(j);
+            const __m256i kv = _mm256_set1_epi32(k);
+            const __m256i partnerIdx = _mm256_xor_si256(lane, jv);
+            //a lane keeps the minimum when it is the lower of its pair in an
+            //ascending block, or the upper of its pair in a descending one
+            const __m256i lower = _mm256_cmpeq_epi32(_mm256_and_si256(lane, jv), zero);
+            for(int r = 0; r < Regs; ++r)
+            {
+                __m256i index = _mm256_add_epi32(lane, _mm256_set1_epi32(8 * r));
+                __m256i descending = _mm256_cmpeq_epi32(_mm256_and_si256(index, kv), kv);
+                __m256i keepMin = _mm256_xor_si256(lower, descending);
+
+                __m256i partner = _mm256_permutevar8x32_epi32(v[r], partnerIdx);
+                __m256i lo = _mm256_min_epu32(v[r], partner);
+                __m256i hi = _mm256_max_epu32(v[r], partner);
+                v[r] = _mm256_blendv_epi8(hi, lo, keepMin);
+            }
+        }
+    }
+
+    for(int r = 0; r < Regs; ++r)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(buf + 8 * r), v[r]);
+    }
+}
+
+/** The scalar version of avx2BitonicSort. std::min and std::max compile to
+    conditional moves, so it is branchless as well.
+
+    @param buf - the keys to sort
+    @param size - the number of keys in @p buf, a power of two
+*/
+inline void
+scalarBitonicSort (std::uint32_t* buf, std::size_t size)
+{
+    for(std::size_t k = 2; k <= size; k <<= 1)
+    {
+        for(std::size_t j = k >> 1; j > 0; j >>= 1)
+        {
+            for(std::size_t i = 0; i < size; ++i)
+            {
+                std::size_t other = i ^ j;
+                if(other < i) { continue; }
+                std::uint32_t lo = std::min(buf[i], buf[other]);
+                std::uint32_t hi = std::max(buf[i], buf[other]);
+                bool ascending = (i & k) == 0;
+                buf[i] = ascending ? lo : hi;
+                buf[other] = ascending ? hi : lo;
+            }
+        }
+    }
+}
+
+/** Sorts the range [first, last) with a sorting network, if it holds at
+    most NETWORK_MAX contiguous 32-bit unsigned keys ordered by plain <.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param less - the ordering to sort by
+
+    @return - true if the range was sorted, false if the caller has to sort
+        it some other way
+*/
+template<std::random_access_iterator Iter, typename Compare>
+bool
+networkSort (Iter first, Iter last, Compare)
+{
+    if constexpr (std::contiguous_iterator<Iter> && isDefaultLess<Compare>
+        && std::is_same_v<std::iter_value_t<Iter>, std::uint32_t>)
+    {
+        std::size_t size = std::distance(first, last);
+        if(size > NETWORK_MAX) { return false; }
+        if(size < 2) { return true; }
+
+        //pad with the largest key, which ends up past the copied range
+        alignas(32) std::uint32_t buf[NETWORK_MAX];
+        std::size_t padded = std::max<std::size_t>(std::bit_ceil(size), 8);
+        std::copy(first, last, buf);
+        std::fill(buf + size, buf + padded, std::numeric_limits<std::uint32_t>::max());
+
+        if(simdLevel() == SimdLevel::Scalar) { scalarBitonicSort(buf, padded); }
+        else if(padded == 8) { avx2BitonicSort<1>(buf); }
+        else if(padded == 16) { avx2BitonicSort<2>(buf); }
+        else if(padded == 32) { avx2BitonicSort<4>(buf); }
+        else { avx2BitonicSort<8>(buf); }
+
+        std::copy(buf, buf + size, std::to_address(first));
+        return true;
+    }
+    else {
+        return false;
+    }
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
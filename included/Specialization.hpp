@@ -0,0 +1,180 @@
+/*
+  Filename   : Specialization.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: Compile-time versions of the serial quicksort's kernels.
+               Contiguous iterators can be swapped for the raw pointers
+               behind them, insertion sort can shift trivially copyable
+               elements with one memmove per insertion instead of moving
+               them one at a time, and the cutoff can be a template
+               parameter, which bounds the leaf loops by a constant the
+               compiler can unroll against. Each is chosen when the sort is
+               built, so each build can be timed against the others.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef SPECIALIZATION_H
+#define SPECIALIZATION_H
+
+/************************************************************/
+// System includes
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+/************************************************************/
+// Local includes
+
+/************************************************************/
+// Using declarations
+
+/** A cutoff known at compile time. It converts to its value, so it can be
+    passed wherever a run-time cutoff is taken.
+*/
+template<std::size_t N>
+using FixedCutoff = std::integral_constant<std::size_t, N>;
+
+//the cutoffs a fixed-cutoff sort is instantiated for
+using FixedCutoffs = std::index_sequence<8, 12, 16, 24, 32, 48, 64, 96, 128>;
+
+/** True when Cutoff is a FixedCutoff. */
+template<typename Cutoff>
+constexpr bool isFixedCutoff = false;
+
+template<std::size_t N>
+constexpr bool isFixedCutoff<FixedCutoff<N>> = true;
+
+/** True when the elements Iter points to can be shifted with memmove: they
+    are stored contiguously and trivially copyable.
+*/
+template<typename Iter>
+constexpr bool canShift = std::contiguous_iterator<Iter> && std::is_trivially_copyable_v<std::iter_value_t<Iter>>;
+
+/************************************************************/
+
+/** The raw pointer behind a contiguous iterator.
+
+    @param it - the iterator to unwrap
+
+    @return - the address it points to if it is contiguous, else it itself
+*/
+template<std::random_access_iterator Iter>
+constexpr auto
+rawIterator (Iter it)
+{
+    if constexpr (std::contiguous_iterator<Iter>) { return std::to_address(it); }
+    else { return it; }
+}
+
+/** Calls f with the FixedCutoff equal to cutoff, if there is one among
+    FixedCutoffs.
+
+    @param cutoff - the cutoff given at run time
+    @param f - the function to call with the FixedCutoff
+
+    @return - true if f was called
+*/
+template<typename Function, std::size_t... Ns>
+bool
+withFixedCutoff (std::size_t cutoff, const Function &f, std::index_sequence<Ns...>)
+{
+    return ((cutoff == Ns && (f(FixedCutoff<Ns>{}), true)) || ...);
+}
+
+template<typename Function>
+bool
+withFixedCutoff (std::size_t cutoff, const Function &f)
+{
+    return withFixedCutoff(cutoff, f, FixedCutoffs{});
+}
+
+/************************************************************/
+
+/** Inserts *cur into the sorted range [first, cur). When Shift is set and
+    the elements can be shifted, the hole is found by comparisons alone and
+    the elements after it are moved up by a single memmove.
+
+    @param first - the start of the sorted range
+    @param cur - the element to insert, just past the sorted range
+    @param less - the ordering to sort by
+*/
+template<bool Shift, std::random_access_iterator Iter, typename Compare>
+inline void
+insertBackward (Iter first, Iter cur, Compare less)
+{
+    if constexpr (Shift && canShift<Iter>)
+    {
+        using T = std::iter_value_t<Iter>;
+
+        T* base = std::to_address(first);
+        T* pos = std::to_address(cur);
+        if(pos == base || !less(*pos, pos[-1])) { return; }
+
+        T key = *pos;
+        T* hole = pos - 1;
+        while (hole != base && less(key, hole[-1])) { --hole; }
+        std::memmove(hole + 1, hole, (pos - hole) * sizeof(T));
+        *hole = key;
+    }
+    else {
+        auto key = std::move(*cur);
+        Iter hole = cur;
+        while (hole != first && less(key, *std::prev(hole)))
+        {
+            *hole = std::move(*std::prev(hole));
+            --hole;
+        }
+        *hole = std::move(key);
+    }
+}
+
+/** Sorts [first, last) with insertion sort, shifting with memmove.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param less - the ordering to sort by
+*/
+template<std::contiguous_iterator Iter, typename Compare>
+    requires canShift<Iter>
+void
+shiftInsertionSort (Iter first, Iter last, Compare less)
+{
+    if(std::distance(first, last) < 2) { return; }
+
+    for(Iter cur = std::next(first); cur != last; ++cur) { insertBackward<true>(first, cur, less); }
+}
+
+/** Sorts [first, last), which holds at most N elements, with insertion
+    sort. The outer loop runs to the constant N and stops at the end of the
+    range, so its trip count is known when the sort is compiled.
+
+    @param N - the most elements the range can hold
+    @param Shift - whether to shift trivially copyable elements with memmove
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param less - the ordering to sort by
+*/
+template<std::size_t N, bool Shift, std::random_access_iterator Iter, typename Compare>
+void
+boundedInsertionSort (Iter first, Iter last, Compare less)
+{
+    std::size_t size = std::distance(first, last);
+    for(std::size_t i = 1; i < N; ++i)
+    {
+        if(i >= size) { return; }
+        insertBackward<Shift>(first, first + i, less);
+    }
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
@@ -0,0 +1,161 @@
+/*
+  Filename   : StableSort.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: Sorts that keep equal elements in their original order. A
+               3-way partition that moves the equal and greater elements
+               out to a buffer and back, so the quicksorts can be made
+               stable, and a parallel stable mergesort: the multiway
+               mergesort with each chunk sorted by a bottom-up mergesort.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef STABLE_SORT_H
+#define STABLE_SORT_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+/************************************************************/
+// Local includes
+
+#include "FinishingPass.hpp"
+#include "PowerSort.hpp"
+#include "MultiwayMerge.hpp"
+
+/************************************************************/
+// Using declarations
+
+/************************************************************/
+
+/** Partitions the range [begin, end) such that all elements less than
+    pivot come first, then all elements equal to it, then all elements
+    greater than it, each group in its original order. The less elements
+    are packed down in place, while the others go to a buffer, the equal
+    ones from its front and the greater ones from its back.
+
+    NOTE: each thread keeps its buffer between calls, so it ends up as
+    large as the largest range that thread partitioned
+
+    @param begin - the start of the range to partition
+    @param end - one past the end of the range to partition
+    @param pivot - the value on which the range should be partitioned
+    @param less - the ordering to partition by
+
+    @return - a pair such that all elements to the left of pair.first
+            are less than pivot, all elements between pair.first and
+            pair.second are equal to pivot, and all elements after
+            pair.second are greater than the pivot.
+*/
+template<std::random_access_iterator Iter, typename Value, typename Compare>
+std::pair<Iter, Iter>
+stablePartition (Iter begin, Iter end, const Value &pivot, Compare less)
+{
+    using T = std::iter_value_t<Iter>;
+
+    thread_local std::vector<T> buffer;
+    std::size_t size = std::distance(begin, end);
+    if(buffer.size() < size) { buffer.resize(size); }
+
+    Iter low = begin;
+    auto equal = buffer.begin();
+    auto greater = buffer.begin() + size;
+    for(Iter cur = begin; cur != end; ++cur)
+    {
+        if(less(*cur, pivot))
+        {
+            if(low != cur) { *low = std::move(*cur); }
+            ++low;
+        }
+        else if(less(pivot, *cur)) { *--greater = std::move(*cur); }
+        else { *equal++ = std::move(*cur); }
+    }
+
+    //the greater elements were stored back to front
+    Iter high = std::move(buffer.begin(), equal, low);
+    std::move(std::make_reverse_iterator(buffer.begin() + size), std::make_reverse_iterator(greater), high);
+    return {low, high};
+}
+
+/** Sorts [first, last) with a bottom-up mergesort, stably. Blocks of
+    cutoff elements are insertion sorted, then merged in pairs of
+    doubling width.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param cutoff - the size of the insertion sorted blocks
+    @param less - the ordering to sort by
+*/
+template<std::random_access_iterator Iter, typename Compare>
+void
+stableMergeSort (Iter first, Iter last, std::size_t cutoff, Compare less)
+{
+    using T = std::iter_value_t<Iter>;
+
+    std::size_t size = std::distance(first, last);
+    std::size_t block = std::max<std::size_t>(1, cutoff);
+    for(std::size_t start = 0; start < size; start += block)
+    {
+        insertionPass(first + start, first + std::min(size, start + block), less);
+    }
+
+    std::vector<T> buffer(size / 2 + 1);
+    for(std::size_t width = block; width < size; width *= 2)
+    {
+        for(std::size_t start = 0; start + width < size; start += 2 * width)
+        {
+            mergeRuns(first + start, first + start + width, first + std::min(size, start + 2 * width), buffer, less);
+        }
+    }
+}
+
+/** Computes the heap memory parallelStableSort uses besides the range.
+
+    @param size - the number of elements to be sorted
+    @param threads - the number of threads sorting
+
+    @return - the size of the merge buffers, in bytes
+*/
+template<typename T>
+std::size_t
+parallelStableSortExtraBytes (std::size_t size, std::size_t threads)
+{
+    std::size_t chunks = std::max<std::size_t>(1, threads);
+    return multiwayMergeExtraBytes<T>(size, chunks) + chunks * (size / chunks / 2 + 1) * sizeof(T);
+}
+
+/** Sorts [first, last) in parallel, stably. Each thread mergesorts one
+    chunk and the chunks are then merged with multiwayMergeSort, whose
+    loser trees take equal elements from earlier chunks first.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param cutoff - the size of the insertion sorted blocks
+    @param less - the ordering to sort by
+    @param threads - the number of chunks, and of threads to use
+    @param forEach - called as forEach(count, f), it must call f(i) for
+        every i in [0, count) in parallel and return once all have finished
+*/
+template<std::random_access_iterator Iter, typename Compare, typename ForEach>
+void
+parallelStableSort (Iter first, Iter last, std::size_t cutoff, Compare less, std::size_t threads, const ForEach &forEach)
+{
+    multiwayMergeSort(first, last, less, threads, [&] (Iter begin, Iter end) {
+        stableMergeSort(begin, end, cutoff, less);
+    }, forEach);
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/
@@ -0,0 +1,383 @@
+/*
+  Filename   : StringSort.hpp
+  Author     : Peter Freedman
+  Course     : CSCI 476
+  Assignment : Final Project
+  Description: Sorts for strings that do not compare the same prefixes over
+               and over. A multikey quicksort partitions on one character
+               at a time, and only moves on to the next character within
+               the strings equal to the pivot, so every character is looked
+               at about log n times. The characters at the current depth are
+               cached in an array, which the partitions scan instead of
+               following each string's pointer. The parallel sort cuts the
+               range into one chunk per thread, multikey quicksorts each
+               chunk and notes the longest common prefix (LCP) of every pair
+               of neighbours, splits the chunks on sampled splitters, and
+               has each thread merge its pieces with an LCP-aware merge,
+               which skips the characters the heads are known to share.
+*/
+
+/************************************************************/
+// Macro guard to prevent multiple inclusions
+
+#ifndef STRING_SORT_H
+#define STRING_SORT_H
+
+/************************************************************/
+// System includes
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/************************************************************/
+// Local includes
+
+/************************************************************/
+// Using declarations
+
+//the number of samples per thread the splitters are chosen from
+const static std::size_t STRING_OVERSAMPLE = 16;
+
+/** A sorted run of strings and the LCP of each with the one before it. */
+template<typename S>
+struct LcpRun
+{
+    S* strings;
+    std::size_t* lcps;
+    std::size_t size;
+};
+
+/************************************************************/
+
+/** The character of s at depth, or 0 past its end.
+
+    NOTE: strings are ordered as if they ended in a 0 character, so a
+    string holding a 0 byte only sorts correctly up to that byte
+*/
+template<typename S>
+inline unsigned char
+charAt (const S &s, std::size_t depth)
+{
+    std::string_view view(s);
+    return depth < view.size() ? view[depth] : 0;
+}
+
+/** Compares a and b, which are known to share their first depth
+    characters.
+
+    @return - the length of their common prefix, and whether b comes
+        before a
+*/
+inline std::pair<std::size_t, bool>
+compareFrom (std::string_view a, std::string_view b, std::size_t depth)
+{
+    std::size_t length = std::min(a.size(), b.size());
+    while (depth < length && a[depth] == b[depth]) { ++depth; }
+    if(depth == length) { return {depth, b.size() < a.size()}; }
+    return {depth, static_cast<unsigned char>(b[depth]) < static_cast<unsigned char>(a[depth])};
+}
+
+/** Multikey quicksorts the n strings at strs, all of which share their
+    first depth characters.
+
+    @param strs - the start of the strings
+    @param cache - an array of n characters, holding the characters of
+        the strings at depth if cached is true
+    @param n - the number of strings
+    @param depth - the length of the prefix the strings share
+    @param cutoff - the size at or below which the strings are insertion
+        sorted
+    @param cached - whether cache already holds the characters at depth
+*/
+template<std::random_access_iterator Iter>
+void
+multikeyQuickSort (Iter strs, unsigned char* cache, std::size_t n, std::size_t depth, std::size_t cutoff, bool cached)
+{
+    while (n > std::max<std::size_t>(1, cutoff))
+    {
+        if(!cached)
+        {
+            for(std::size_t i = 0; i < n; ++i) { cache[i] = charAt(strs[i], depth); }
+        }
+
+        unsigned char a = cache[0], b = cache[n / 2], c = cache[n - 1];
+        unsigned char pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+
+        //the characters are partitioned, and the strings moved along with
+        //them, into [0, lt) less, [lt, gt) equal and [gt, n) greater
+        std::size_t lt = 0, cur = 0, gt = n;
+        while (cur < gt)
+        {
+            if(cache[cur] < pivot)
+            {
+                std::swap(cache[lt], cache[cur]);
+                std::iter_swap(strs + lt++, strs + cur++);
+            }
+            else if(cache[cur] > pivot)
+            {
+                std::swap(cache[cur], cache[--gt]);
+                std::iter_swap(strs + cur, strs + gt);
+            }
+            else { ++cur; }
+        }
+
+        //the cache still holds the characters at depth on either side
+        multikeyQuickSort(strs, cache, lt, depth, cutoff, true);
+        multikeyQuickSort(strs + gt, cache + gt, n - gt, depth, cutoff, true);
+
+        //strings equal to the pivot share one more character, unless they
+        //have all ended
+        if(pivot == 0) { return; }
+        strs += lt;
+        cache += lt;
+        n = gt - lt;
+        ++depth;
+        cached = false;
+    }
+
+    for(std::size_t i = 1; i < n; ++i)
+    {
+        auto val = std::move(strs[i]);
+        std::size_t j = i;
+        for(; j > 0 && compareFrom(strs[j - 1], val, depth).second; --j) { strs[j] = std::move(strs[j - 1]); }
+        strs[j] = std::move(val);
+    }
+}
+
+/** Sorts the strings [first, last) with a multikey quicksort.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param cutoff - the size at or below which ranges are insertion sorted
+*/
+template<std::random_access_iterator Iter>
+void
+multikeyQuickSort (Iter first, Iter last, std::size_t cutoff)
+{
+    std::size_t size = std::distance(first, last);
+    std::vector<unsigned char> cache(size);
+    multikeyQuickSort(first, cache.data(), size, 0, cutoff, false);
+}
+
+/** Merges two sorted runs into out, using their LCPs to skip the
+    characters the heads share with the last string written. When one head
+    shares more with it than the other, that head is the smaller, and no
+    characters are compared at all.
+
+    @param a - the first run. Its strings are moved out.
+    @param b - the second run, whose strings come after equal ones of a
+    @param out - where the merged run is written, with room for both
+*/
+template<typename S>
+void
+lcpMerge (LcpRun<S> a, LcpRun<S> b, LcpRun<S> out)
+{
+    std::size_t i = 0, j = 0, k = 0;
+    //the LCP of each head with the last string written
+    std::size_t ha = 0, hb = 0;
+    auto takeA = [&] (std::size_t lcp) {
+        out.strings[k] = std::move(a.strings[i]);
+        out.lcps[k++] = lcp;
+        ha = ++i < a.size ? a.lcps[i] : 0;
+    };
+    auto takeB = [&] (std::size_t lcp) {
+        out.strings[k] = std::move(b.strings[j]);
+        out.lcps[k++] = lcp;
+        hb = ++j < b.size ? b.lcps[j] : 0;
+    };
+
+    while (i < a.size && j < b.size)
+    {
+        if(ha > hb) { takeA(ha); }
+        else if(hb > ha) { takeB(hb); }
+        else {
+            auto [lcp, bFirst] = compareFrom(a.strings[i], b.strings[j], ha);
+            if(bFirst)
+            {
+                takeB(hb);
+                ha = lcp;
+            }
+            else {
+                takeA(ha);
+                hb = lcp;
+            }
+        }
+    }
+    while (i < a.size) { takeA(ha); }
+    while (j < b.size) { takeB(hb); }
+}
+
+/** Merges sorted runs into one, in rounds of pairwise LCP merges that
+    go back and forth between two buffers.
+
+    @param runs - the runs to merge
+    @param out - where the merged run is written
+    @param temp - a buffer of the same size as out
+
+    @return - out
+*/
+template<typename S>
+LcpRun<S>
+lcpMergeRuns (std::vector<LcpRun<S>> runs, LcpRun<S> out, LcpRun<S> temp)
+{
+    std::erase_if(runs, [] (const LcpRun<S> &run) { return run.size == 0; });
+
+    //the last round must write to out, so the first writes to temp when
+    //the number of rounds is even
+    std::size_t rounds = 0;
+    for(std::size_t count = runs.size(); count > 1; count = (count + 1) / 2) { ++rounds; }
+    LcpRun<S> target = rounds % 2 == 0 ? temp : out;
+    LcpRun<S> other = rounds % 2 == 0 ? out : temp;
+
+    if(rounds == 0)
+    {
+        if(!runs.empty())
+        {
+            std::move(runs[0].strings, runs[0].strings + runs[0].size, out.strings);
+            std::copy(runs[0].lcps, runs[0].lcps + runs[0].size, out.lcps);
+        }
+        return out;
+    }
+
+    while (runs.size() > 1)
+    {
+        std::vector<LcpRun<S>> merged;
+        std::size_t offset = 0;
+        for(std::size_t r = 0; r < runs.size(); r += 2)
+        {
+            LcpRun<S> dest{target.strings + offset, target.lcps + offset, runs[r].size};
+            if(r + 1 < runs.size())
+            {
+                dest.size += runs[r + 1].size;
+                lcpMerge(runs[r], runs[r + 1], dest);
+            }
+            else {
+                std::move(runs[r].strings, runs[r].strings + runs[r].size, dest.strings);
+                std::copy(runs[r].lcps, runs[r].lcps + runs[r].size, dest.lcps);
+            }
+            merged.push_back(dest);
+            offset += dest.size;
+        }
+        runs = std::move(merged);
+        std::swap(target, other);
+    }
+    return out;
+}
+
+/** Computes the heap memory parallelStringSort uses besides the range.
+
+    @param size - the number of strings to be sorted
+    @param threads - the number of threads sorting
+
+    @return - the size of the character caches, the LCPs, the merge
+        buffers and the samples, in bytes. The characters themselves are
+        moved, never copied.
+*/
+template<typename S>
+std::size_t
+parallelStringSortExtraBytes (std::size_t size, std::size_t threads)
+{
+    if(threads <= 1) { return size; }
+    std::size_t samples = threads * threads * STRING_OVERSAMPLE * sizeof(std::string_view);
+    return size + 3 * size * sizeof(std::size_t) + 2 * size * sizeof(S) + samples;
+}
+
+/** Sorts the strings [first, last) in parallel. Each thread multikey
+    quicksorts a chunk and finds its LCPs, then the chunks are split on
+    splitters sampled from them, and each thread LCP-merges the pieces of
+    every chunk between two splitters.
+
+    @param first - the start of the range to be sorted
+    @param last - the end (exclusive) of the range to be sorted
+    @param cutoff - the size at or below which ranges are insertion sorted
+    @param threads - the number of chunks, and of threads to use
+    @param forEach - called as forEach(count, f), it must call f(i) for
+        every i in [0, count) in parallel and return once all have finished
+*/
+template<std::contiguous_iterator Iter, typename ForEach>
+void
+parallelStringSort (Iter first, Iter last, std::size_t cutoff, std::size_t threads, const ForEach &forEach)
+{
+    using S = std::iter_value_t<Iter>;
+
+    std::size_t size = std::distance(first, last);
+    std::size_t chunks = std::max<std::size_t>(1, std::min(threads, size / STRING_OVERSAMPLE));
+    if(chunks == 1)
+    {
+        multikeyQuickSort(first, last, cutoff);
+        return;
+    }
+
+    //the strings are moved into data so the runs can be plain pointers
+    std::vector<S> data(size);
+    std::vector<std::size_t> lcps(size);
+    std::vector<std::size_t> start(chunks + 1);
+    for(std::size_t c = 0; c <= chunks; ++c) { start[c] = c * size / chunks; }
+
+    forEach(chunks, [&] (std::size_t c) {
+        std::move(first + start[c], first + start[c + 1], data.begin() + start[c]);
+        multikeyQuickSort(data.begin() + start[c], data.begin() + start[c + 1], cutoff);
+        lcps[start[c]] = 0;
+        for(std::size_t i = start[c] + 1; i < start[c + 1]; ++i)
+        {
+            lcps[i] = compareFrom(data[i - 1], data[i], 0).first;
+        }
+    });
+
+    //evenly spaced samples of every sorted chunk, of which every
+    //STRING_OVERSAMPLE-th becomes a splitter
+    std::vector<std::string_view> samples;
+    std::size_t perChunk = chunks * STRING_OVERSAMPLE;
+    for(std::size_t c = 0; c < chunks; ++c)
+    {
+        std::size_t length = start[c + 1] - start[c];
+        for(std::size_t s = 0; s < perChunk; ++s) { samples.push_back(data[start[c] + (2 * s + 1) * length / (2 * perChunk)]); }
+    }
+    std::sort(samples.begin(), samples.end());
+
+    //bounds[t][c] is where thread t's piece of chunk c starts
+    std::vector<std::vector<std::size_t>> bounds(chunks + 1, std::vector<std::size_t>(chunks));
+    for(std::size_t c = 0; c < chunks; ++c)
+    {
+        bounds[0][c] = start[c];
+        bounds[chunks][c] = start[c + 1];
+        for(std::size_t t = 1; t < chunks; ++t)
+        {
+            std::string_view splitter = samples[t * samples.size() / chunks];
+            bounds[t][c] = std::lower_bound(data.begin() + start[c], data.begin() + start[c + 1], splitter,
+                [] (const S &s, std::string_view v) { return std::string_view(s) < v; }) - data.begin();
+        }
+    }
+    std::vector<std::size_t> offset(chunks + 1, 0);
+    for(std::size_t t = 0; t < chunks; ++t)
+    {
+        offset[t + 1] = offset[t];
+        for(std::size_t c = 0; c < chunks; ++c) { offset[t + 1] += bounds[t + 1][c] - bounds[t][c]; }
+    }
+
+    //each thread merges into its part of the range, through a buffer
+    std::vector<S> temp(size);
+    std::vector<std::size_t> tempLcps(size);
+    std::vector<std::size_t> outLcps(size);
+    forEach(chunks, [&] (std::size_t t) {
+        std::vector<LcpRun<S>> runs;
+        for(std::size_t c = 0; c < chunks; ++c)
+        {
+            runs.push_back({data.data() + bounds[t][c], lcps.data() + bounds[t][c], bounds[t + 1][c] - bounds[t][c]});
+        }
+        std::size_t length = offset[t + 1] - offset[t];
+        LcpRun<S> out{std::to_address(first + offset[t]), outLcps.data() + offset[t], length};
+        lcpMergeRuns(runs, out, LcpRun<S>{temp.data() + offset[t], tempLcps.data() + offset[t], length});
+    });
+}
+
+/************************************************************/
+
+#endif
+
+/************************************************************/